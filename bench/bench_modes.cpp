@@ -0,0 +1,283 @@
+// Бенчмарк режимов на хосте (env:bench).
+// Прогоняет runMode() для каждого режима и каждого количества диодов
+// с фиксированным seed и виртуальными часами, печатает JSON в stdout.
+// Также сравнивает пакетные пути с попиксельными на MAX_LEDS пикселях:
+// hsv2rgbStrip() с CHSV и NoiseRow с inoise8 (время, вызовы inoise8 на кадр,
+// отклонение от точного шума). Корректность проверяют тесты в test/.
+//
+//   pio run -e bench && .pio/build/bench/program [--frames 2000] [--seed 1337] [--out bench.json]
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "config.h"
+#include "led_state.h"
+#include "led_modes.h"
+#include "palette.h"
+#include "noise_row.h"
+#include "random_pool.h"
+#include "native_platform.h"
+
+#define BENCH_WARMUP_FRAMES 50
+#define BENCH_HSV_PASSES 20000
+#define BENCH_NOISE_FRAMES 2000
+
+static const uint16_t BENCH_LED_COUNTS[] = {50, 150, MAX_LEDS};
+
+struct ModeResult {
+  uint8_t mode;
+  uint16_t numLeds;
+  uint32_t frames;
+  uint64_t meanNs;
+  uint64_t p99Ns;
+  uint64_t maxNs;
+};
+
+static ModeResult benchMode(uint8_t mode, uint16_t numLeds, uint32_t frames, uint16_t seed) {
+  initLEDState();
+  ledState.numLeds = numLeds;
+  ledState.currentMode = mode;
+  ledState.transitionMs = 0;  // Замеряем сам режим, без перехода из предыдущего
+
+  // Часы идут с тем же шагом, что и на устройстве: интервал кадра режима
+  uint8_t frameMs = MODE_REGISTRY[mode].frameMs;
+
+  random16_set_seed(seed);
+  randomSeed(seed);
+  seedRandomPool(seed);
+  fill_solid(leds, MAX_LEDS, CRGB::Black);
+
+  // Прогрев: заполняем внутреннее состояние режимов (огонь, снег, светлячки)
+  for (uint32_t i = 0; i < BENCH_WARMUP_FRAMES; i++) {
+    nativeAdvanceClock(frameMs);
+    runMode(mode);
+  }
+
+  std::vector<uint64_t> samples;
+  samples.reserve(frames);
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < frames; i++) {
+    nativeAdvanceClock(frameMs);
+
+    auto start = std::chrono::steady_clock::now();
+    runMode(mode);
+    auto end = std::chrono::steady_clock::now();
+
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    samples.push_back(ns);
+    total += ns;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  ModeResult result;
+  result.mode = mode;
+  result.numLeds = numLeds;
+  result.frames = frames;
+  result.meanNs = frames ? total / frames : 0;
+  result.p99Ns = frames ? samples[std::min<size_t>((size_t)frames * 99 / 100, frames - 1)] : 0;
+  result.maxNs = frames ? samples.back() : 0;
+  return result;
+}
+
+struct HsvKernelResult {
+  const char* sat;
+  uint64_t perPixelNs;  // Проход CHSV -> CRGB по одному пикселю
+  uint64_t stripNs;     // Тот же проход через hsv2rgbStrip()
+};
+
+static CHSV hsvInput[MAX_LEDS];
+static CRGB hsvExpected[MAX_LEDS], hsvActual[MAX_LEDS];
+
+// Случайные тон и яркость; насыщенность 255 или вся шкала
+static void fillHsvInput(bool fullSat, uint16_t seed) {
+  random16_set_seed(seed);
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    uint8_t hue = random8();
+    uint8_t sat = fullSat ? 255 : random8();
+    hsvInput[i] = CHSV(hue, sat, random8());
+  }
+}
+
+static void hsvPerPixel() {
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    hsvExpected[i] = hsvInput[i];
+  }
+}
+
+static HsvKernelResult benchHsvKernel(bool fullSat, uint16_t seed) {
+  fillHsvInput(fullSat, seed);
+  HsvKernelResult result = {fullSat ? "255" : "mixed", 0, 0};
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < BENCH_HSV_PASSES; pass++) {
+    hsvInput[0].h = pass;  // Не даём компилятору вынести проход из цикла
+    hsvPerPixel();
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for (uint32_t pass = 0; pass < BENCH_HSV_PASSES; pass++) {
+    hsvInput[0].h = pass;
+    hsv2rgbStrip(hsvActual, hsvInput, MAX_LEDS);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  result.perPixelNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count() / BENCH_HSV_PASSES;
+  result.stripNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count() / BENCH_HSV_PASSES;
+  return result;
+}
+
+// Строка шума как в режиме при scale/speed = 128
+struct NoiseScenario {
+  const char* name;
+  uint16_t dx;      // Шаг x между пикселями
+  uint16_t xStep;   // Сдвиг строки по x за кадр
+  uint16_t yStep;   // Сдвиг по времени за кадр (0 = одномерный шум)
+};
+
+static const NoiseScenario NOISE_SCENARIOS[] = {
+  {"plasma", 55, 0, 3},
+  {"noise", 175, 128, 0},
+  {"aurora", 30, 0, 10},
+};
+
+struct NoiseRowResult {
+  uint64_t perPixelNs;  // inoise8 на каждый пиксель
+  uint64_t rowNs;       // NoiseRow::update() + next() на каждый пиксель
+  uint32_t samplesPerFrame;  // Вызовов inoise8 в NoiseRow, в среднем за кадр
+  uint8_t maxError;
+  uint32_t meanErrorX100;
+};
+
+static uint8_t noiseExpected[MAX_LEDS], noiseActual[MAX_LEDS];
+static NoiseRow benchNoise;
+
+static void noisePerPixel(const NoiseScenario& sc, uint32_t frame) {
+  uint32_t x0 = frame * sc.xStep;
+  uint16_t y = frame * sc.yStep;
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    uint16_t x = x0 + i * sc.dx;
+    noiseExpected[i] = sc.yStep ? inoise8(x, y) : inoise8(x);
+  }
+}
+
+static void noiseRow(const NoiseScenario& sc, uint32_t frame) {
+  uint32_t x0 = frame * sc.xStep;
+  if (sc.yStep) {
+    benchNoise.update(x0, sc.dx, frame * sc.yStep, MAX_LEDS);
+  } else {
+    benchNoise.update(x0, sc.dx, MAX_LEDS);
+  }
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    noiseActual[i] = benchNoise.next();
+  }
+}
+
+static NoiseRowResult benchNoiseRow(const NoiseScenario& sc) {
+  NoiseRowResult result = {0, 0, 0, 0, 0};
+  
+  // Отклонение и число вызовов inoise8 - отдельным прогоном, без замера времени
+  benchNoise = NoiseRow();
+  uint64_t samples = 0, errorSum = 0;
+  for (uint32_t frame = 0; frame < BENCH_NOISE_FRAMES; frame++) {
+    noisePerPixel(sc, frame);
+    noiseRow(sc, frame);
+    samples += benchNoise.samples;
+    for (uint16_t i = 0; i < MAX_LEDS; i++) {
+      uint8_t error = abs((int)noiseActual[i] - (int)noiseExpected[i]);
+      errorSum += error;
+      if (error > result.maxError) result.maxError = error;
+    }
+  }
+  result.samplesPerFrame = samples / BENCH_NOISE_FRAMES;
+  result.meanErrorX100 = errorSum * 100 / ((uint64_t)BENCH_NOISE_FRAMES * MAX_LEDS);
+  
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < BENCH_NOISE_FRAMES; frame++) {
+    noisePerPixel(sc, frame);
+  }
+  auto mid = std::chrono::steady_clock::now();
+  benchNoise = NoiseRow();
+  for (uint32_t frame = 0; frame < BENCH_NOISE_FRAMES; frame++) {
+    noiseRow(sc, frame);
+  }
+  auto end = std::chrono::steady_clock::now();
+  
+  result.perPixelNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count() / BENCH_NOISE_FRAMES;
+  result.rowNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count() / BENCH_NOISE_FRAMES;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  uint32_t frames = 2000;
+  uint16_t seed = 1337;
+  const char* outPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = (uint16_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      outPath = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--frames N] [--seed S] [--out FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  FILE* out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out) {
+    perror("bench output");
+    return 1;
+  }
+
+  nativeOptions.virtualClock = true;
+  initLEDState();
+  initLEDs();
+
+  fprintf(out, "{\n  \"frames\": %u,\n  \"seed\": %u,\n", frames, seed);
+
+  fprintf(out, "  \"hsvKernel\": [\n");
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    HsvKernelResult r = benchHsvKernel(pass == 0, seed);
+    fprintf(out, "    {\"sat\": \"%s\", \"numLeds\": %u, \"perPixelNs\": %llu, \"stripNs\": %llu}%s\n",
+            r.sat, MAX_LEDS, (unsigned long long)r.perPixelNs, (unsigned long long)r.stripNs,
+            pass == 0 ? "," : "");
+  }
+  fprintf(out, "  ],\n");
+
+  fprintf(out, "  \"noiseRow\": [\n");
+  const uint8_t scenarioCount = sizeof(NOISE_SCENARIOS) / sizeof(NOISE_SCENARIOS[0]);
+  for (uint8_t s = 0; s < scenarioCount; s++) {
+    NoiseRowResult r = benchNoiseRow(NOISE_SCENARIOS[s]);
+    fprintf(out,
+            "    {\"row\": \"%s\", \"numLeds\": %u, \"perPixelNs\": %llu, \"rowNs\": %llu, "
+            "\"inoisePerFrame\": %u, \"maxError\": %u, \"meanError\": %u.%02u}%s\n",
+            NOISE_SCENARIOS[s].name, MAX_LEDS, (unsigned long long)r.perPixelNs,
+            (unsigned long long)r.rowNs, r.samplesPerFrame, r.maxError,
+            r.meanErrorX100 / 100, r.meanErrorX100 % 100, s + 1 < scenarioCount ? "," : "");
+  }
+  fprintf(out, "  ],\n  \"results\": [\n");
+
+  bool first = true;
+  for (uint16_t numLeds : BENCH_LED_COUNTS) {
+    for (uint8_t mode = 0; mode < TOTAL_MODES; mode++) {
+      ModeResult r = benchMode(mode, numLeds, frames, seed);
+      fprintf(out,
+              "%s    {\"mode\": %u, \"name\": \"%s\", \"numLeds\": %u, \"budgetNs\": %lu, "
+              "\"nsPerFrame\": %llu, \"nsPerPixel\": %llu, \"p99Ns\": %llu, \"maxNs\": %llu}",
+              first ? "" : ",\n", r.mode, MODE_REGISTRY[r.mode].name, r.numLeds,
+              MODE_REGISTRY[r.mode].frameMs * 1000000ul, (unsigned long long)r.meanNs,
+              (unsigned long long)(r.meanNs / r.numLeds), (unsigned long long)r.p99Ns,
+              (unsigned long long)r.maxNs);
+      first = false;
+    }
+  }
+
+  fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) fclose(out);
+  return 0;
+}
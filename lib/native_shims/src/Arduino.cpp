@@ -0,0 +1,152 @@
+#include "Arduino.h"
+#include "native_platform.h"
+#include <stdarg.h>
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+NativeOptions nativeOptions = {8080, "eeprom.bin", nullptr, false, 0, "flash.bin"};
+
+static const auto bootTime = std::chrono::steady_clock::now();
+static uint64_t virtualMicros = 0;
+static time_t wallOffset = 0;  // Поправка, заданная через settimeofday()
+
+uint32_t micros() {
+  if (nativeOptions.virtualClock) {
+    return (uint32_t)virtualMicros;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - bootTime;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+uint32_t millis() {
+  if (nativeOptions.virtualClock) {
+    return (uint32_t)(virtualMicros / 1000);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - bootTime;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+void nativeAdvanceClock(uint32_t ms) {
+  virtualMicros += (uint64_t)ms * 1000;
+}
+
+void delay(uint32_t ms) {
+  if (nativeOptions.virtualClock) {
+    nativeAdvanceClock(ms);
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+  nativeServiceNetwork();
+}
+
+time_t native_time(time_t* out) {
+  // Скобки вокруг имени отключают макрос time() из Arduino.h
+  time_t now = (time)(nullptr) + wallOffset;
+  if (out) *out = now;
+  return now;
+}
+
+int native_settimeofday(const struct timeval* tv, const void* tz) {
+  (void)tz;
+  if (tv) {
+    wallOffset = tv->tv_sec - (time)(nullptr);
+  }
+  return 0;
+}
+
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2, const char* server3) {
+  (void)server1;
+  (void)server2;
+  (void)server3;
+  // POSIX TZ инвертирует знак: "UTC-5" означает UTC+5
+  long offsetHours = (gmtOffsetSec + daylightOffsetSec) / 3600;
+  char tz[32];
+  snprintf(tz, sizeof(tz), "UTC%+ld", -offsetHours);
+  setenv("TZ", tz, 1);
+  tzset();
+}
+
+static std::mt19937 rng(0);
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return (long)(rng() % (unsigned long)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  rng.seed((uint32_t)seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+size_t HardwareSerial::write(const String& s) {
+  return fwrite(s.c_str(), 1, s.length(), stdout);
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int written = vprintf(fmt, args);
+  va_end(args);
+  return written < 0 ? 0 : (size_t)written;
+}
+
+String EspClass::getResetReason() {
+  return String("Native start");
+}
+
+static rst_info nativeResetInfo = {REASON_DEFAULT_RST, 0};
+static uint32_t rtcUserMemory[128];
+
+rst_info* EspClass::getResetInfoPtr() {
+  return &nativeResetInfo;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset >= 128 || offset * 4 + size > sizeof(rtcUserMemory)) {
+    return false;
+  }
+  memcpy(data, &rtcUserMemory[offset], size);
+  return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+  if (offset >= 128 || offset * 4 + size > sizeof(rtcUserMemory)) {
+    return false;
+  }
+  memcpy(&rtcUserMemory[offset], data, size);
+  return true;
+}
+
+void EspClass::restart() {
+  Serial.println("ESP.restart() -> exit");
+  fflush(stdout);
+  exit(0);
+}
+
+uint32_t EspClass::getCycleCount() {
+  auto elapsed = std::chrono::steady_clock::now() - bootTime;
+  uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return (uint32_t)(ns * getCpuFreqMHz() / 1000);
+}
+
+uint32_t EspClass::getFreeHeap() {
+  // На хосте куча не ограничена; отдаём типичное значение D1 mini,
+  // чтобы логи и /api/debug выглядели как на устройстве
+  return 40000;
+}
@@ -0,0 +1,107 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Заглушка Arduino core для env:native.
+// Прошивка собирается как обычный процесс Linux: время берётся из часов хоста
+// (или из виртуальных часов, см. native_platform.h), Serial пишет в stdout.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctime>
+#include <time.h>
+#include <sys/time.h>
+#include "WString.h"
+
+#define PROGMEM
+#define PGM_P const char*
+#define F(str) (str)
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Время
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+// time()/settimeofday() перенаправляются на программные часы процесса,
+// чтобы /api/time/set не трогал системное время хоста
+time_t native_time(time_t* out);
+int native_settimeofday(const struct timeval* tv, const void* tz);
+void configTime(long gmtOffsetSec, int daylightOffsetSec, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+#define time(out) native_time(out)
+#define settimeofday(tv, tz) native_settimeofday(tv, tz)
+
+// Математика
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// Serial -> stdout
+class HardwareSerial {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(const String& s);
+
+  template <typename T>
+  size_t print(const T& value) { return write(String(value)); }
+  template <typename T>
+  size_t println(const T& value) { return write(String(value)) + write(String("\n")); }
+  size_t println() { return write(String("\n")); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+extern HardwareSerial Serial;
+
+// Причина сброса (user_interface.h ядра ESP8266)
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,       // Включение питания
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,      // ESP.restart(), перезагрузка после OTA
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6        // Кнопка / вывод RST
+};
+
+struct rst_info {
+  uint32_t reason;
+  uint32_t exccause;
+};
+
+// ESP API
+class EspClass {
+public:
+  String getResetReason();
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getCycleCount();   // Эмуляция счётчика тактов 80 МГц по часам хоста
+  uint8_t getCpuFreqMHz() { return 80; }
+  
+  // Флеш (native_flash.cpp): адрес = смещение в файле nativeOptions.flashPath.
+  // Как на NOR-флеше, запись только сбрасывает биты, поднимает их стирание сектора
+  bool flashEraseSector(uint32_t sector);
+  bool flashWrite(uint32_t address, const uint32_t* data, size_t size);
+  bool flashRead(uint32_t address, uint32_t* data, size_t size);
+  
+  // Пользовательская RTC память: 128 блоков по 4 байта, offset - номер блока.
+  // Процесс на хосте всегда стартует как после включения питания (память нулевая)
+  rst_info* getResetInfoPtr();
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size);
+};
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+extern EspClass ESP;
+
+#endif
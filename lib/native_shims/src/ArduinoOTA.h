@@ -0,0 +1,43 @@
+#ifndef NATIVE_ARDUINOOTA_H
+#define NATIVE_ARDUINOOTA_H
+
+#include <Arduino.h>
+#include <functional>
+
+#define U_FLASH 0
+#define U_FS 100
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR
+} ota_error_t;
+
+// OTA на хосте не бывает: колбэки сохраняются, но никогда не вызываются
+class ArduinoOTAClass {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+  typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+  void setHostname(const char* hostname) { (void)hostname; }
+  void onStart(THandlerFunction fn) { startCallback = fn; }
+  void onEnd(THandlerFunction fn) { endCallback = fn; }
+  void onProgress(THandlerFunction_Progress fn) { progressCallback = fn; }
+  void onError(THandlerFunction_Error fn) { errorCallback = fn; }
+  void begin() {}
+  void handle() {}
+  int getCommand() { return U_FLASH; }
+
+private:
+  THandlerFunction startCallback;
+  THandlerFunction endCallback;
+  THandlerFunction_Progress progressCallback;
+  THandlerFunction_Error errorCallback;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,48 @@
+#include "EEPROM.h"
+#include "native_platform.h"
+#include <stdio.h>
+
+EEPROMClass EEPROM;
+
+void EEPROMClass::begin(size_t size) {
+  // Незаписанная флеш читается как 0xFF
+  data.assign(size, 0xFF);
+  dirty = false;
+
+  FILE* f = fopen(nativeOptions.eepromPath, "rb");
+  if (f) {
+    size_t got = fread(data.data(), 1, size, f);
+    (void)got;
+    fclose(f);
+  }
+}
+
+bool EEPROMClass::commit() {
+  if (!dirty || data.empty()) return true;
+
+  FILE* f = fopen(nativeOptions.eepromPath, "wb");
+  if (!f) return false;
+  size_t written = fwrite(data.data(), 1, data.size(), f);
+  fclose(f);
+  dirty = false;
+  return written == data.size();
+}
+
+bool EEPROMClass::end() {
+  bool ok = commit();
+  data.clear();
+  return ok;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+  if (address < 0 || (size_t)address >= data.size()) return 0;
+  return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (address < 0 || (size_t)address >= data.size()) return;
+  if (data[address] != value) {
+    data[address] = value;
+    dirty = true;
+  }
+}
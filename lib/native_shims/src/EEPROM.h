@@ -0,0 +1,46 @@
+#ifndef NATIVE_EEPROM_H
+#define NATIVE_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+// EEPROM, эмулированный файлом (nativeOptions.eepromPath).
+// Семантика как у ESP8266: begin() читает образ, commit() записывает его целиком.
+class EEPROMClass {
+private:
+  std::vector<uint8_t> data;
+  bool dirty = false;
+
+public:
+  void begin(size_t size);
+  bool commit();
+  bool end();
+
+  uint8_t read(int address) const;
+  void write(int address, uint8_t value);
+  size_t length() const { return data.size(); }
+  uint8_t* getDataPtr() { dirty = true; return data.data(); }
+
+  template <typename T>
+  T& get(int address, T& value) {
+    if (address >= 0 && address + sizeof(T) <= data.size()) {
+      memcpy((void*)&value, &data[address], sizeof(T));
+    }
+    return value;
+  }
+
+  template <typename T>
+  const T& put(int address, const T& value) {
+    if (address >= 0 && address + sizeof(T) <= data.size()) {
+      memcpy(&data[address], (const void*)&value, sizeof(T));
+      dirty = true;
+    }
+    return value;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
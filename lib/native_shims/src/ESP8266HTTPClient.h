@@ -0,0 +1,21 @@
+#ifndef NATIVE_ESP8266HTTPCLIENT_H
+#define NATIVE_ESP8266HTTPCLIENT_H
+
+#include <Arduino.h>
+#include "WiFiClient.h"
+
+#define HTTP_CODE_OK 200
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+
+// Исходящий HTTP на хосте не нужен: время берётся из часов хоста,
+// поэтому клиент всегда отвечает отказом соединения
+class HTTPClient {
+public:
+  bool begin(WiFiClient& client, const String& url) { (void)client; (void)url; return true; }
+  void setTimeout(uint16_t timeout) { (void)timeout; }
+  int GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+  String getString() { return String(); }
+  void end() {}
+};
+
+#endif
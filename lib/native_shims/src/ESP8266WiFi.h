@@ -0,0 +1,29 @@
+#ifndef NATIVE_ESP8266WIFI_H
+#define NATIVE_ESP8266WIFI_H
+
+#include <Arduino.h>
+#include "IPAddress.h"
+
+// WiFi на хосте "подключается" мгновенно, адрес всегда localhost
+enum WiFiMode_t { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 };
+enum wl_status_t { WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6 };
+
+class ESP8266WiFiClass {
+public:
+  bool mode(WiFiMode_t m) { (void)m; return true; }
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet) {
+    (void)local; (void)gateway; (void)subnet;
+    return true;
+  }
+  wl_status_t begin(const char* ssid, const char* password) {
+    (void)ssid; (void)password;
+    return WL_CONNECTED;
+  }
+  wl_status_t status() { return WL_CONNECTED; }
+  int32_t RSSI() { return -40; }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef NATIVE_ESPASYNCTCP_H
+#define NATIVE_ESPASYNCTCP_H
+
+// На хосте TCP обслуживает ESPAsyncWebServer.cpp через неблокирующие сокеты
+
+#endif
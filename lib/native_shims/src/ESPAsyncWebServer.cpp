@@ -0,0 +1,263 @@
+#include "ESPAsyncWebServer.h"
+#include "native_platform.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+
+static std::vector<AsyncWebServer*> activeServers;
+
+void nativeServiceNetwork() {
+  for (AsyncWebServer* srv : activeServers) {
+    srv->poll();
+  }
+}
+
+static const char* statusText(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Status";
+  }
+}
+
+static String urlDecode(const std::string& in) {
+  std::string out;
+  for (size_t i = 0; i < in.size(); i++) {
+    if (in[i] == '+') {
+      out += ' ';
+    } else if (in[i] == '%' && i + 2 < in.size()) {
+      out += (char)strtol(in.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += in[i];
+    }
+  }
+  return String(out);
+}
+
+static uint8_t parseMethod(const std::string& m) {
+  if (m == "GET") return HTTP_GET;
+  if (m == "POST") return HTTP_POST;
+  if (m == "DELETE") return HTTP_DELETE;
+  return 0;
+}
+
+const char* AsyncWebServerRequest::methodToString() const {
+  switch (requestMethod) {
+    case HTTP_GET: return "GET";
+    case HTTP_POST: return "POST";
+    case HTTP_DELETE: return "DELETE";
+    default: return "UNKNOWN";
+  }
+}
+
+bool AsyncWebServerRequest::hasParam(const char* name) const {
+  for (const AsyncWebParameter& p : params) {
+    if (p.name() == name) return true;
+  }
+  return false;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const char* name) {
+  for (AsyncWebParameter& p : params) {
+    if (p.name() == name) return &p;
+  }
+  return nullptr;
+}
+
+void AsyncWebServerRequest::send(int code, const String& contentType, const String& content) {
+  if (responded) return;  // Как и в оригинале, отвечаем только один раз
+  responded = true;
+  responseCode = code;
+  responseType = contentType;
+  responseBody = content;
+}
+
+AsyncWebServer::~AsyncWebServer() {
+  if (listenFd >= 0) close(listenFd);
+  for (size_t i = 0; i < activeServers.size(); i++) {
+    if (activeServers[i] == this) {
+      activeServers.erase(activeServers.begin() + i);
+      break;
+    }
+  }
+}
+
+void AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+  routes.push_back({String(uri), method, onRequest, nullptr});
+}
+
+void AsyncWebServer::on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                        ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody) {
+  (void)onUpload;
+  routes.push_back({String(uri), method, onRequest, onBody});
+}
+
+void AsyncWebServer::begin() {
+  // Порт из конфигурации устройства (80) заменяется на порт хоста
+  port = nativeOptions.httpPort;
+
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    perror("socket");
+    return;
+  }
+
+  int yes = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 8) < 0) {
+    perror("bind/listen");
+    close(listenFd);
+    listenFd = -1;
+    return;
+  }
+
+  fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+  activeServers.push_back(this);
+  printf("[native] HTTP on http://127.0.0.1:%u/\n", port);
+}
+
+void AsyncWebServer::poll() {
+  if (listenFd < 0) return;
+
+  for (;;) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) break;  // EAGAIN: больше нет ожидающих соединений
+    handleClient(fd);
+    close(fd);
+  }
+}
+
+void AsyncWebServer::handleClient(int fd) {
+  // Локальный клиент присылает запрос целиком почти сразу; таймаут защищает loop() от зависания
+  timeval timeout = {0, 200000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string raw;
+  size_t headerEnd = std::string::npos;
+  size_t contentLength = 0;
+  char buf[2048];
+
+  for (;;) {
+    ssize_t got = recv(fd, buf, sizeof(buf), 0);
+    if (got <= 0) break;
+    raw.append(buf, (size_t)got);
+
+    if (headerEnd == std::string::npos) {
+      headerEnd = raw.find("\r\n\r\n");
+      if (headerEnd == std::string::npos) continue;
+
+      size_t clPos = raw.find("Content-Length:");
+      if (clPos == std::string::npos) clPos = raw.find("content-length:");
+      if (clPos != std::string::npos && clPos < headerEnd) {
+        contentLength = strtoul(raw.c_str() + clPos + 15, nullptr, 10);
+      }
+    }
+    if (raw.size() >= headerEnd + 4 + contentLength) break;
+  }
+
+  if (headerEnd == std::string::npos) return;
+
+  // Стартовая строка: METHOD /path?query HTTP/1.1
+  size_t lineEnd = raw.find("\r\n");
+  std::string startLine = raw.substr(0, lineEnd);
+  size_t sp1 = startLine.find(' ');
+  size_t sp2 = startLine.find(' ', sp1 + 1);
+  if (sp1 == std::string::npos || sp2 == std::string::npos) return;
+
+  std::string target = startLine.substr(sp1 + 1, sp2 - sp1 - 1);
+  std::string path = target;
+  std::string query;
+  size_t q = target.find('?');
+  if (q != std::string::npos) {
+    path = target.substr(0, q);
+    query = target.substr(q + 1);
+  }
+
+  AsyncWebServerRequest request(parseMethod(startLine.substr(0, sp1)), String(path));
+
+  size_t pos = 0;
+  while (pos < query.size()) {
+    size_t amp = query.find('&', pos);
+    if (amp == std::string::npos) amp = query.size();
+    std::string pair = query.substr(pos, amp - pos);
+    size_t eq = pair.find('=');
+    if (eq != std::string::npos) {
+      request.addParam(urlDecode(pair.substr(0, eq)), urlDecode(pair.substr(eq + 1)));
+    } else if (!pair.empty()) {
+      request.addParam(urlDecode(pair), String());
+    }
+    pos = amp + 1;
+  }
+
+  // +1 байт под терминатор: обработчики WebSocket на устройстве пишут data[len] = 0
+  std::vector<uint8_t> body(contentLength + 1, 0);
+  size_t bodyLen = raw.size() > headerEnd + 4 ? raw.size() - headerEnd - 4 : 0;
+  if (bodyLen > contentLength) bodyLen = contentLength;
+  memcpy(body.data(), raw.data() + headerEnd + 4, bodyLen);
+
+  dispatch(request, body.data(), bodyLen);
+
+  if (!request.responded) {
+    request.send(500, "text/plain", "No response");
+  }
+
+  std::string response = "HTTP/1.0 " + std::to_string(request.responseCode) + " " +
+                         statusText(request.responseCode) + "\r\n";
+  if (request.responseType.length() > 0) {
+    response += "Content-Type: " + request.responseType.str() + "\r\n";
+  }
+  response += "Content-Length: " + std::to_string(request.responseBody.length()) + "\r\n";
+  response += "Connection: close\r\n\r\n";
+  response += request.responseBody.str();
+
+  size_t sent = 0;
+  while (sent < response.size()) {
+    ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) break;
+    sent += (size_t)n;
+  }
+}
+
+void AsyncWebServer::dispatch(AsyncWebServerRequest& request, uint8_t* body, size_t bodyLen) {
+  const std::string& url = request.url().str();
+
+  for (Route& route : routes) {
+    if (!(route.method & request.method())) continue;
+
+    const std::string& uri = route.uri.str();
+    bool match = url == uri || (url.compare(0, uri.size(), uri) == 0 && url.size() > uri.size() &&
+                                url[uri.size()] == '/');
+    if (!match) continue;
+
+    if (route.onBody && bodyLen > 0) {
+      route.onBody(&request, body, bodyLen, 0, bodyLen);
+    }
+    if (route.onRequest) {
+      route.onRequest(&request);
+    }
+    return;
+  }
+
+  if (notFoundHandler) {
+    notFoundHandler(&request);
+  } else {
+    request.send(404, "text/plain", "Not Found");
+  }
+}
@@ -0,0 +1,151 @@
+#ifndef NATIVE_ESPASYNCWEBSERVER_H
+#define NATIVE_ESPASYNCWEBSERVER_H
+
+// Заглушка ESPAsyncWebServer для env:native.
+// Поднимает простой HTTP/1.0 сервер на 127.0.0.1:nativeOptions.httpPort.
+// Запросы обслуживаются между итерациями loop() (nativeServiceNetwork()),
+// как это делает стек lwIP на ESP8266, поэтому обработчики не гоняются с loop().
+// Маршрутизация повторяет оригинал: "/api/mode" обрабатывает и "/api/mode/...".
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include "IPAddress.h"
+
+#ifndef HTTP_ANY
+#define HTTP_ANY 0xFF
+#endif
+#ifndef HTTP_GET
+#define HTTP_GET 0x01
+#endif
+#ifndef HTTP_POST
+#define HTTP_POST 0x02
+#endif
+#ifndef HTTP_DELETE
+#define HTTP_DELETE 0x04
+#endif
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebParameter {
+private:
+  String paramName;
+  String paramValue;
+
+public:
+  AsyncWebParameter(const String& name, const String& value) : paramName(name), paramValue(value) {}
+  const String& name() const { return paramName; }
+  const String& value() const { return paramValue; }
+};
+
+class AsyncWebServerRequest {
+private:
+  uint8_t requestMethod;
+  String requestUrl;
+  std::vector<AsyncWebParameter> params;
+  bool responded = false;
+  int responseCode = 0;
+  String responseType;
+  String responseBody;
+
+  friend class AsyncWebServer;
+
+public:
+  AsyncWebServerRequest(uint8_t method, const String& url) : requestMethod(method), requestUrl(url) {}
+
+  uint8_t method() const { return requestMethod; }
+  const String& url() const { return requestUrl; }
+  const char* methodToString() const;
+
+  bool hasParam(const char* name) const;
+  AsyncWebParameter* getParam(const char* name);
+  void addParam(const String& name, const String& value) { params.push_back(AsyncWebParameter(name, value)); }
+
+  void send(int code, const String& contentType = String(), const String& content = String());
+  void send_P(int code, const String& contentType, PGM_P content) { send(code, contentType, String(content)); }
+};
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, const String& filename, size_t index,
+                           uint8_t* data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest* request, uint8_t* data, size_t len,
+                           size_t index, size_t total)> ArBodyHandlerFunction;
+
+// WebSocket на хосте не поддерживается: клиентов всегда 0, рассылка логов пропускается
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+#define WS_TEXT 0x01
+#define WS_BINARY 0x02
+
+typedef struct {
+  uint8_t message_opcode;
+  uint32_t num;
+  uint8_t final;
+  uint8_t masked;
+  uint8_t opcode;
+  uint64_t len;
+  uint8_t mask[4];
+  uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocketClient {
+public:
+  uint32_t id() const { return 0; }
+  IPAddress remoteIP() const { return IPAddress(127, 0, 0, 1); }
+  void text(const String& message) { (void)message; }
+};
+
+class AsyncWebSocket;
+typedef std::function<void(AsyncWebSocket* server, AsyncWebSocketClient* client, AwsEventType type,
+                           void* arg, uint8_t* data, size_t len)> AwsEventHandler;
+
+class AsyncWebHandler {
+public:
+  virtual ~AsyncWebHandler() {}
+};
+
+class AsyncWebSocket : public AsyncWebHandler {
+private:
+  String path;
+  AwsEventHandler handler;
+
+public:
+  explicit AsyncWebSocket(const String& url) : path(url) {}
+  void onEvent(AwsEventHandler fn) { handler = fn; }
+  size_t count() const { return 0; }
+  void textAll(const String& message) { (void)message; }
+  void cleanupClients() {}
+};
+
+class AsyncWebServer {
+private:
+  struct Route {
+    String uri;
+    WebRequestMethodComposite method;
+    ArRequestHandlerFunction onRequest;
+    ArBodyHandlerFunction onBody;
+  };
+
+  uint16_t port;
+  int listenFd = -1;
+  std::vector<Route> routes;
+  ArRequestHandlerFunction notFoundHandler;
+
+  void handleClient(int fd);
+  void dispatch(AsyncWebServerRequest& request, uint8_t* body, size_t bodyLen);
+
+public:
+  explicit AsyncWebServer(uint16_t port) : port(port) {}
+  ~AsyncWebServer();
+
+  void on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest);
+  void on(const char* uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+          ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr);
+  void onNotFound(ArRequestHandlerFunction fn) { notFoundHandler = fn; }
+  void addHandler(AsyncWebHandler* handler) { (void)handler; }
+  void begin();
+
+  // Вызывается из nativeServiceNetwork(): принимает и обслуживает ожидающие соединения
+  void poll();
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <stdio.h>
+#include "WString.h"
+
+class IPAddress {
+private:
+  uint8_t octets[4];
+
+public:
+  IPAddress() : octets{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return octets[index]; }
+
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buf);
+  }
+};
+
+#endif
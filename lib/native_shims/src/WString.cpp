@@ -0,0 +1,41 @@
+#include "WString.h"
+#include <stdio.h>
+#include <string.h>
+
+String::String(double value, unsigned char decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", decimals, value);
+  s = buf;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t pos = s.find(c, from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const char* str, unsigned int from) const {
+  size_t pos = s.find(str ? str : "", from);
+  return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+  if (from > to) {
+    unsigned int tmp = from;
+    from = to;
+    to = tmp;
+  }
+  if (from >= s.length()) return String();
+  if (to > s.length()) to = s.length();
+  return String(s.substr(from, to - from));
+}
+
+void String::replace(const char* find, const char* replacement) {
+  size_t findLen = strlen(find);
+  if (findLen == 0) return;
+  size_t replLen = strlen(replacement);
+  size_t pos = 0;
+  while ((pos = s.find(find, pos)) != std::string::npos) {
+    s.replace(pos, findLen, replacement);
+    pos += replLen;
+  }
+}
@@ -0,0 +1,69 @@
+#ifndef NATIVE_WSTRING_H
+#define NATIVE_WSTRING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+// Минимальная замена Arduino String поверх std::string.
+// Покрывает только то, что использует прошивка (конкатенация, replace, indexOf, substring, toInt).
+class String {
+private:
+  std::string s;
+
+public:
+  String() {}
+  String(const char* cstr) : s(cstr ? cstr : "") {}
+  String(const std::string& str) : s(str) {}
+  String(char c) : s(1, c) {}
+  String(int value) : s(std::to_string(value)) {}
+  String(unsigned int value) : s(std::to_string(value)) {}
+  String(long value) : s(std::to_string(value)) {}
+  String(unsigned long value) : s(std::to_string(value)) {}
+  String(long long value) : s(std::to_string(value)) {}
+  String(unsigned long long value) : s(std::to_string(value)) {}
+  String(float value, unsigned char decimals = 2) : String((double)value, decimals) {}
+  String(double value, unsigned char decimals = 2);
+
+  const char* c_str() const { return s.c_str(); }
+  unsigned int length() const { return (unsigned int)s.length(); }
+  bool isEmpty() const { return s.empty(); }
+
+  String& operator+=(const String& rhs) { s += rhs.s; return *this; }
+  String& operator+=(const char* rhs) { s += (rhs ? rhs : ""); return *this; }
+  String& operator+=(char c) { s += c; return *this; }
+  String& operator+=(int v) { s += std::to_string(v); return *this; }
+  String& operator+=(unsigned int v) { s += std::to_string(v); return *this; }
+  String& operator+=(long v) { s += std::to_string(v); return *this; }
+  String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+
+  bool concat(const String& rhs) { s += rhs.s; return true; }
+  bool concat(const char* rhs) { s += (rhs ? rhs : ""); return true; }
+
+  friend String operator+(const String& lhs, const String& rhs) { return String(lhs.s + rhs.s); }
+  friend String operator+(const String& lhs, const char* rhs) { return String(lhs.s + (rhs ? rhs : "")); }
+  friend String operator+(const char* lhs, const String& rhs) { return String((lhs ? lhs : "") + rhs.s); }
+
+  bool operator==(const String& rhs) const { return s == rhs.s; }
+  bool operator==(const char* rhs) const { return s == (rhs ? rhs : ""); }
+  bool operator!=(const String& rhs) const { return s != rhs.s; }
+  char operator[](unsigned int index) const { return index < s.length() ? s[index] : 0; }
+
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const char* str, unsigned int from = 0) const;
+  int indexOf(const String& str, unsigned int from = 0) const { return indexOf(str.c_str(), from); }
+  String substring(unsigned int from) const { return substring(from, length()); }
+  String substring(unsigned int from, unsigned int to) const;
+  void replace(const char* find, const char* replacement);
+  void replace(const String& find, const String& replacement) { replace(find.c_str(), replacement.c_str()); }
+  bool startsWith(const char* prefix) const { return s.compare(0, strlen_(prefix), prefix) == 0; }
+  long toInt() const { return strtol(s.c_str(), nullptr, 10); }
+  float toFloat() const { return strtof(s.c_str(), nullptr); }
+
+  const std::string& str() const { return s; }
+
+private:
+  static size_t strlen_(const char* str) { return std::char_traits<char>::length(str); }
+};
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef NATIVE_WIFICLIENT_H
+#define NATIVE_WIFICLIENT_H
+
+class WiFiClient {
+};
+
+#endif
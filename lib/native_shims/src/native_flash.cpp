@@ -0,0 +1,68 @@
+#include "Arduino.h"
+#include "native_platform.h"
+#include <stdio.h>
+#include <vector>
+
+// Флеш, эмулированная файлом. Файл растёт по мере записи,
+// всё за его концом читается как стёртое (0xFF).
+
+static std::vector<uint8_t> loadFlash() {
+  std::vector<uint8_t> image;
+  FILE* f = fopen(nativeOptions.flashPath, "rb");
+  if (f) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size > 0) {
+      image.resize((size_t)size);
+      size_t got = fread(image.data(), 1, image.size(), f);
+      image.resize(got);
+    }
+    fclose(f);
+  }
+  return image;
+}
+
+static bool saveFlash(const std::vector<uint8_t>& image) {
+  FILE* f = fopen(nativeOptions.flashPath, "wb");
+  if (!f) return false;
+  size_t written = fwrite(image.data(), 1, image.size(), f);
+  fclose(f);
+  return written == image.size();
+}
+
+bool EspClass::flashEraseSector(uint32_t sector) {
+  std::vector<uint8_t> image = loadFlash();
+  size_t start = (size_t)sector * SPI_FLASH_SEC_SIZE;
+  if (image.size() < start + SPI_FLASH_SEC_SIZE) {
+    image.resize(start + SPI_FLASH_SEC_SIZE, 0xFF);
+  }
+  memset(&image[start], 0xFF, SPI_FLASH_SEC_SIZE);
+  return saveFlash(image);
+}
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t* data, size_t size) {
+  // Как на ESP8266: адрес и длина кратны 4
+  if ((address | size) & 3) return false;
+  
+  std::vector<uint8_t> image = loadFlash();
+  if (image.size() < address + size) {
+    image.resize(address + size, 0xFF);
+  }
+  const uint8_t* bytes = (const uint8_t*)data;
+  for (size_t i = 0; i < size; i++) {
+    image[address + i] &= bytes[i];
+  }
+  return saveFlash(image);
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size) {
+  if ((address | size) & 3) return false;
+  
+  std::vector<uint8_t> image = loadFlash();
+  uint8_t* bytes = (uint8_t*)data;
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = address + i < image.size() ? image[address + i] : 0xFF;
+  }
+  return true;
+}
@@ -0,0 +1,45 @@
+#include "native_frame_sink.h"
+#include "native_platform.h"
+#include <stdio.h>
+
+static uint32_t framesShown = 0;
+static FILE* dumpFile = nullptr;
+
+NativeFrameSink& nativeFrameSink() {
+  static NativeFrameSink sink;
+  return sink;
+}
+
+uint32_t nativeFramesShown() {
+  return framesShown;
+}
+
+void NativeFrameSink::showPixels(PixelController<RGB>& pixels) {
+  framesShown++;
+
+  if (nativeOptions.dumpPath == nullptr) return;
+  if (dumpFile == nullptr) {
+    dumpFile = fopen(nativeOptions.dumpPath, "wb");
+    if (dumpFile == nullptr) {
+      perror("frame dump");
+      nativeOptions.dumpPath = nullptr;
+      return;
+    }
+  }
+
+  uint32_t now = millis();
+  uint16_t count = (uint16_t)pixels.size();
+  uint8_t header[6] = {
+    (uint8_t)now, (uint8_t)(now >> 8), (uint8_t)(now >> 16), (uint8_t)(now >> 24),
+    (uint8_t)count, (uint8_t)(count >> 8)
+  };
+  fwrite(header, 1, sizeof(header), dumpFile);
+
+  while (pixels.has(1)) {
+    uint8_t rgb[3] = {pixels.loadAndScale0(), pixels.loadAndScale1(), pixels.loadAndScale2()};
+    fwrite(rgb, 1, sizeof(rgb), dumpFile);
+    pixels.advanceData();
+    pixels.stepDithering();
+  }
+  fflush(dumpFile);
+}
@@ -0,0 +1,23 @@
+#ifndef NATIVE_FRAME_SINK_H
+#define NATIVE_FRAME_SINK_H
+
+#include <FastLED.h>
+
+// Замена WS2812B контроллера на хосте: вместо вывода на пин каждый show()
+// пишет кадр (уже с учётом яркости и коррекции FastLED) в nativeOptions.dumpPath.
+//
+// Формат файла - последовательность кадров:
+//   uint32_t millis    (little-endian)
+//   uint16_t count     (little-endian)
+//   uint8_t  rgb[count * 3]
+class NativeFrameSink : public CPixelLEDController<RGB> {
+public:
+  void init() override {}
+
+protected:
+  void showPixels(PixelController<RGB>& pixels) override;
+};
+
+NativeFrameSink& nativeFrameSink();
+
+#endif
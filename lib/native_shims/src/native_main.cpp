@@ -0,0 +1,78 @@
+// Точка входа env:native: крутит setup()/loop() прошивки как обычный процесс.
+//
+//   .pio/build/native/program [--port 8080] [--eeprom eeprom.bin] [--flash flash.bin]
+//                             [--dump frames.bin] [--frames N] [--virtual-clock]
+//
+// С --virtual-clock millis() продвигается на 1 мс за итерацию loop(),
+// и прогон с тем же EEPROM даёт побайтно одинаковый дамп кадров.
+
+#ifndef NATIVE_NO_MAIN
+
+#include <Arduino.h>
+#include <ArduinoOTA.h>
+#include <ESP8266WiFi.h>
+#include "native_platform.h"
+
+ESP8266WiFiClass WiFi;
+ArduinoOTAClass ArduinoOTA;
+
+// Тесты (pio test -e native) собираются вместе с прошивкой, main() у них свой
+#ifndef PIO_UNIT_TESTING
+
+void setup();
+void loop();
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [--port N] [--eeprom PATH] [--flash PATH] [--dump PATH] [--frames N] [--virtual-clock]\n",
+          argv0);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hasValue = i + 1 < argc;
+
+    if (strcmp(arg, "--port") == 0 && hasValue) {
+      nativeOptions.httpPort = (uint16_t)atoi(argv[++i]);
+    } else if (strcmp(arg, "--eeprom") == 0 && hasValue) {
+      nativeOptions.eepromPath = argv[++i];
+    } else if (strcmp(arg, "--flash") == 0 && hasValue) {
+      nativeOptions.flashPath = argv[++i];
+    } else if (strcmp(arg, "--dump") == 0 && hasValue) {
+      nativeOptions.dumpPath = argv[++i];
+    } else if (strcmp(arg, "--frames") == 0 && hasValue) {
+      nativeOptions.maxFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(arg, "--virtual-clock") == 0) {
+      nativeOptions.virtualClock = true;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  setup();
+
+  for (;;) {
+    loop();
+    nativeServiceNetwork();
+
+    if (nativeOptions.maxFrames > 0 && nativeFramesShown() >= nativeOptions.maxFrames) {
+      break;
+    }
+
+    // Виртуальные часы идут шагами, реальные - не даём циклу крутить ядро на 100%
+    if (nativeOptions.virtualClock) {
+      nativeAdvanceClock(1);
+    } else {
+      delay(1);
+    }
+  }
+
+  fflush(stdout);
+  return 0;
+}
+
+#endif  // PIO_UNIT_TESTING
+
+#endif
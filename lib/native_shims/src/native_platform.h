@@ -0,0 +1,27 @@
+#ifndef NATIVE_PLATFORM_H
+#define NATIVE_PLATFORM_H
+
+#include <stdint.h>
+
+// Параметры запуска прошивки на хосте (env:native).
+struct NativeOptions {
+  uint16_t httpPort;        // Порт localhost для AsyncWebServer (80 требует root)
+  const char* eepromPath;   // Файл, в котором живёт эмулированный EEPROM
+  const char* dumpPath;     // Куда писать кадры leds[] (nullptr = не писать)
+  bool virtualClock;        // millis() идёт только вперёд на шаг за итерацию loop()
+  uint32_t maxFrames;       // Остановиться после N показанных кадров (0 = бесконечно)
+  const char* flashPath;    // Файл эмулированной флеши (ESP.flashRead/Write/EraseSector)
+};
+
+extern NativeOptions nativeOptions;
+
+// Виртуальные часы: детерминированное время для воспроизводимых прогонов
+void nativeAdvanceClock(uint32_t ms);
+
+// Счётчик кадров, прошедших через FastLED.show()
+uint32_t nativeFramesShown();
+
+// Обслуживание "TCP стека" между итерациями loop() (аналог yield() на ESP8266)
+void nativeServiceNetwork();
+
+#endif
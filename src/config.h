@@ -19,6 +19,23 @@
 #define MAX_LEDS 300        // Максимальное количество LED
 #define DEFAULT_LEDS 50     // Количество LED по умолчанию
 #define DEFAULT_BRIGHTNESS 128  // Яркость по умолчанию (0-255)
+#define LED_COLOR_CORRECTION TypicalLEDStrip  // Цветокоррекция ленты (UncorrectedColor = без коррекции)
+#define LED_GAMMA 2.2f          // Гамма вывода (1.0 = без коррекции)
+#define LED_DITHER_BELOW 32     // Временной дизеринг для уровней канала на выходе ниже этого
+#define LED_DITHER_MAX_BRIGHTNESS 30  // Дизеринг только при яркости вывода ниже этой (ночь)
+#define DEFAULT_POWER_LIMIT_MA 9000  // Лимит тока ленты по умолчанию (мА), запас под БП 5 В / 10 А
+#define MAX_POWER_LIMIT_MA 60000     // Самый большой лимит тока, который можно задать через API (как в веб-интерфейсе)
+#define LED_RED_MA 16           // Ток канала WS2812B при 255 (мА), модель FastLED
+#define LED_GREEN_MA 11
+#define LED_BLUE_MA 15
+#define LED_IDLE_MA 1           // Ток покоя одного диода (мА)
+#define LED_REFRESH_INTERVAL 1000  // Повтор неизменного кадра на ленту (мс, 0 = не повторять)
+#define FRAME_MAX_INTERVAL_MS 50   // Самый длинный интервал кадра под нагрузкой (20 FPS)
+#define FRAME_CPU_BUDGET_PERCENT 60  // Доля интервала кадра на отрисовку, остальное - сети
+#define FRAME_LATE_TOLERANCE_MS 5  // Опоздание кадра, после которого он считается поздним
+#define DEFAULT_TRANSITION_MS 1000 // Плавный переход между режимами по умолчанию (мс)
+#define MAX_TRANSITION_MS 10000    // Самый длинный переход, который можно задать через API
+#define TRANSITION_SHORT_MS 250    // Короткое затухание, если переход не укладывается в кадр
 
 // Режимы работы
 #define TOTAL_MODES 13      // Общее количество режимов
@@ -37,6 +54,18 @@
 // Расписание
 #define MAX_SCHEDULES 10          // Максимальное количество расписаний
 
+// Хранение настроек (settings_journal.h)
+#define SETTINGS_JOURNAL_SECTORS 4  // Секторов журнала по 4 КБ (начало раздела файловой системы)
+#define SETTINGS_PRESET_SECTORS 2   // Секторов пресетов, сразу за журналом
+#define SETTINGS_SAVE_IDLE_MS 2000      // Сохранять после такой паузы в изменениях (мс)
+#define SETTINGS_SAVE_MAX_AGE_MS 10000  // Но не позже этого от первого несохранённого изменения (мс)
+
+// Кэш горячего состояния в RTC памяти (rtc_state.h)
+#define RTC_STATE_OFFSET 32           // Первый блок (по 4 байта): блоки 0-31 занимает команда OTA (eboot)
+#define RTC_STATE_INTERVAL_MS 1000    // Обновлять образ в RTC не реже (мс)
+#define RTC_STATE_MAX_CRASH_BOOTS 3   // Сбросов по WDT/исключению подряд, после которых старт холодный
+#define RTC_STATE_STABLE_MS 30000     // Работа без сброса, после которой счётчик сбросов обнуляется (мс)
+
 // Логирование
 #define LOG_BUFFER_SIZE 50        // Размер кольцевого буфера логов
 #define LOG_ENABLE_TIMESTAMPS true // Включить временные метки
@@ -1,4 +1,5 @@
 #include "diagnostics.h"
+#include "led_modes.h"
 
 Diagnostics diag;
 
@@ -7,6 +8,18 @@ Diagnostics::Diagnostics() {
     lastLogTime = 0;
     frameCount = 0;
     currentTask = {nullptr, 0, 0, 0, 0};
+    
+    for (uint8_t i = 0; i < TOTAL_MODES; i++) {
+        frameCostUs[i] = 0;
+        frameIntervalMs[i] = 0;  // 0 = not measured yet, use the mode's nominal interval
+    }
+    frameMode = 0xFF;  // No frame rendered yet
+    frameStartUs = 0;
+    framesLate = 0;
+    framesDropped = 0;
+    fpsFrames = 0;
+    fpsWindowStart = 0;
+    fps = 0;
 }
 
 void Diagnostics::loopStart() {
@@ -57,6 +70,71 @@ void Diagnostics::taskEnd() {
     currentTask.name = nullptr;
 }
 
+uint16_t Diagnostics::frameInterval(uint8_t mode) const {
+    if (mode < TOTAL_MODES && frameIntervalMs[mode] > 0) {
+        return frameIntervalMs[mode];
+    }
+    return getModeDescriptor(mode).frameMs;
+}
+
+void Diagnostics::frameStart(uint8_t mode, unsigned long sinceLastMs) {
+    uint16_t interval = frameInterval(mode);
+    
+    // Count frames the loop could not render in time (WiFi, OTA, slow tasks).
+    // The first frame after a mode switch has no meaningful previous frame.
+    if (mode == frameMode) {
+        if (sinceLastMs >= 2UL * interval) {
+            framesDropped += sinceLastMs / interval - 1;
+        } else if (sinceLastMs > (unsigned long)interval + FRAME_LATE_TOLERANCE_MS) {
+            framesLate++;
+        }
+    }
+    
+    frameMode = mode;
+    frameStartUs = micros();
+}
+
+void Diagnostics::frameEnd() {
+    if (frameMode >= TOTAL_MODES) return;
+    
+    uint32_t cost = micros() - frameStartUs;
+    
+    // Exponential moving average (1/8), seeded with the first measurement
+    uint32_t& avg = frameCostUs[frameMode];
+    avg = avg == 0 ? cost : avg - avg / 8 + cost / 8;
+    
+    // Interval at which the frame takes FRAME_CPU_BUDGET_PERCENT of the time,
+    // bounded by the mode's nominal interval and FRAME_MAX_INTERVAL_MS
+    uint16_t minMs = getModeDescriptor(frameMode).frameMs;
+    uint16_t maxMs = minMs > FRAME_MAX_INTERVAL_MS ? minMs : FRAME_MAX_INTERVAL_MS;
+    uint32_t targetMs = (avg * 100UL / FRAME_CPU_BUDGET_PERCENT + 999) / 1000;
+    targetMs = constrain(targetMs, (uint32_t)minMs, (uint32_t)maxMs);
+    
+    // Step by 1 ms per frame so a single slow frame doesn't make the rate jump
+    uint8_t& interval = frameIntervalMs[frameMode];
+    if (interval == 0) {
+        interval = minMs;
+    }
+    if (targetMs > interval) {
+        interval++;
+    } else if (targetMs < interval) {
+        interval--;
+    }
+    
+    // Effective FPS over one-second windows
+    fpsFrames++;
+    unsigned long now = millis();
+    if (now - fpsWindowStart >= 1000) {
+        fps = fpsFrames * 1000.0 / (now - fpsWindowStart);
+        fpsFrames = 0;
+        fpsWindowStart = now;
+    }
+}
+
+uint32_t Diagnostics::getFrameCostUs(uint8_t mode) const {
+    return mode < TOTAL_MODES ? frameCostUs[mode] : 0;
+}
+
 void Diagnostics::logSuspicious(const char* reason, unsigned long duration) {
     String msg = "⚠️ [DIAG] ";
     msg += reason;
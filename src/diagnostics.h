@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "logger.h"
+#include "config.h"
 
 // Thresholds for suspicious behavior
 #define SUSPICIOUS_LOOP_MS 50
@@ -25,6 +26,17 @@ private:
     // Track specific tasks
     TaskStats currentTask;
     
+    // Frame governor: smoothed render + show cost and current interval per mode
+    uint32_t frameCostUs[TOTAL_MODES];
+    uint8_t frameIntervalMs[TOTAL_MODES];
+    uint8_t frameMode;
+    unsigned long frameStartUs;
+    unsigned long framesLate;
+    unsigned long framesDropped;
+    unsigned long fpsFrames;
+    unsigned long fpsWindowStart;
+    float fps;
+    
     void logSuspicious(const char* reason, unsigned long duration);
 
 public:
@@ -36,6 +48,17 @@ public:
     void taskStart(const char* name);
     void taskEnd();  // Ends the currently running task
     
+    // Frame governor. frameStart() gets the time since the previous frame,
+    // frameEnd() measures the frame cost and adjusts the interval for the mode
+    uint16_t frameInterval(uint8_t mode) const;
+    void frameStart(uint8_t mode, unsigned long sinceLastMs);
+    void frameEnd();
+    
+    unsigned long getFramesLate() const { return framesLate; }
+    unsigned long getFramesDropped() const { return framesDropped; }
+    float getEffectiveFps() const { return fps; }
+    uint32_t getFrameCostUs(uint8_t mode) const;
+    
     void printStats();
 };
 
@@ -1,53 +1,445 @@
 #include "led_modes.h"
 #include "led_state.h"
+#include "led_output.h"
+#include "palette.h"
+#include "noise_row.h"
+#include "random_pool.h"
+#include "particles.h"
+
+#include <new>
+
+#ifdef NATIVE_BUILD
+#include "native_frame_sink.h"
+#endif
 
 CRGB leds[MAX_LEDS];
 
+// Состояния режимов. Одновременно работает один режим, поэтому все они
+// живут в общей арене (modeArena), а не в отдельных static переменных.
+// Фазы хранятся с 8 битами дробной части (см. advancePhase)
+struct TwoSinState {
+  uint32_t huePhase = 0;
+};
+
+struct RainbowMarchState {
+  uint32_t huePhase = 0;
+};
+
+struct PlasmaState {
+  uint32_t offsetPhase = 0;
+  NoiseRow noise;
+};
+
+struct NoiseState {
+  uint32_t xPhase = 0;
+};
+
+struct FireState {
+  byte heat[MAX_LEDS] = {};
+  byte prevHeat[MAX_LEDS] = {};  // Тепло до последнего шага симуляции
+  SimClock sim;
+};
+
+// Содержимое, которое движется вдоль ленты (снег). scroll() сдвигает всё
+// на один LED к концу ленты за O(1): меняется только начало кольца,
+// а operator[] переводит номер LED в позицию в кольце.
+struct ScrollBuffer {
+  uint8_t data[MAX_LEDS] = {};
+  uint16_t head = 0;  // Позиция LED 0 в data
+  
+  // Сдвиг к большему индексу. Последний LED кольца становится LED 0, его нужно задать
+  void scroll() {
+    head = head == 0 ? MAX_LEDS - 1 : head - 1;
+  }
+  
+  uint8_t& operator[](uint16_t i) {
+    uint16_t pos = head + i;
+    if (pos >= MAX_LEDS) {
+      pos -= MAX_LEDS;
+    }
+    return data[pos];
+  }
+};
+
+struct SnowfallState {
+  ScrollBuffer snow;            // Яркость снежинки в каждом LED
+  SimClock sim;                 // Шаг падения - fallSpeed мс часов анимации
+};
+
+struct AuroraState {
+  uint32_t timePhase = 0;
+  NoiseRow brightNoise;         // Мерцание яркости
+  NoiseRow hueNoise;            // Дрейф оттенка
+  uint8_t baseHue = 96;         // Начинаем с зелёного (характерный цвет сияния)
+  uint8_t curtainPos = 0;
+  uint8_t curtainWidth = 5;
+  uint32_t lastCurtain = 0;     // animClock.ms последней занавески
+};
+
+struct ConfettiState {
+  ParticlePool particles{PARTICLE_DECAY};
+  SimClock sim;
+};
+
+struct FirefliesState {
+  ParticlePool particles{PARTICLE_PULSE};
+  SimClock sim;
+  uint16_t sinceFlashMs = 0;  // Время симуляции с последней вспышки
+  int16_t flash = -1;         // Светлячок со вспышкой на последнем шаге (-1 = нет)
+};
+
 void initLEDs() {
-  FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, MAX_LEDS);
-  FastLED.setBrightness(ledState.brightness);
-  FastLED.clear();
-  FastLED.show();
+  // Лента выводит outputLeds[]: гамму, яркость, коррекцию и дизеринг
+  // делает выходной каскад (led_output.cpp), а не FastLED
+#ifdef NATIVE_BUILD
+  // На хосте кадры уходят в дамп вместо пина ленты
+  FastLED.addLeds(&nativeFrameSink(), outputLeds, MAX_LEDS);
+#else
+  FastLED.addLeds<WS2812B, LED_PIN, GRB>(outputLeds, MAX_LEDS);
+#endif
+  FastLED.setBrightness(255);
+  FastLED.setDither(DISABLE_DITHER);
+  
+  initOutput();
+  setOutputBrightness(ledState.brightness);
+  fill_solid(leds, MAX_LEDS, CRGB::Black);
+  showLeds();
+}
+
+// Реестр режимов. Порядок строк = номера режимов (сохранены в EEPROM, не переставлять!)
+extern constexpr ModeDescriptor MODE_REGISTRY[TOTAL_MODES] = {
+  // render               name                  speed scale color1       frameMs stateSize
+  {mode_blendwave,      "Смешанные волны",    128, 128, CRGB::Red,   20, 0},
+  {mode_rainbow_beat,   "Радужная пульсация", 128, 128, CRGB::Red,   20, 0},
+  {mode_two_sin,        "Две синусоиды",      128, 128, CRGB::Red,   20, sizeof(TwoSinState)},
+  {mode_confetti,       "Конфетти",           128, 128, CRGB::Red,   20, sizeof(ConfettiState)},
+  {mode_fire,           "Огонь",              128, 128, CRGB::Red,   20, sizeof(FireState)},
+  {mode_rainbow_march,  "Радужный марш",      128, 128, CRGB::Red,   20, sizeof(RainbowMarchState)},
+  {mode_plasma,         "Плазма",             128, 128, CRGB::Red,   20, sizeof(PlasmaState)},
+  {mode_noise,          "Шум",                128, 128, CRGB::Red,   20, sizeof(NoiseState)},
+  {mode_juggle,         "Жонглирование",      128, 128, CRGB::Red,   20, 0},
+  {mode_solid_color,    "Один цвет",          128, 128, CRGB::White, 50, 0},
+  {mode_snowfall,       "Снегопад",           128, 128, CRGB::Red,   20, sizeof(SnowfallState)},
+  {mode_aurora,         "Северное сияние",    128, 128, CRGB::Red,   20, sizeof(AuroraState)},
+  {mode_fireflies,      "Светлячки",          128, 128, CRGB::Red,   20, sizeof(FirefliesState)},
+};
+
+// Лишняя строка не скомпилируется, а недостающая оставит нулевую запись в конце
+static constexpr bool modeRegistryComplete() {
+  for (uint8_t i = 0; i < TOTAL_MODES; i++) {
+    if (MODE_REGISTRY[i].render == nullptr || MODE_REGISTRY[i].name == nullptr) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(modeRegistryComplete(), "MODE_REGISTRY must have exactly TOTAL_MODES entries");
+
+static constexpr uint16_t maxModeStateSize() {
+  uint16_t maxSize = 1;
+  for (uint8_t i = 0; i < TOTAL_MODES; i++) {
+    if (MODE_REGISTRY[i].stateSize > maxSize) maxSize = MODE_REGISTRY[i].stateSize;
+  }
+  return maxSize;
+}
+
+// Арена состояния активного режима: размер = самое большое stateSize в реестре
+alignas(4) static uint8_t modeArena[maxModeStateSize()];
+static uint8_t* activeArena = modeArena;  // Во время перехода подменяется ареной уходящего режима
+static uint8_t arenaOwner = 0xFF;   // Режим, которому сейчас принадлежит арена
+static bool arenaFresh = true;      // Состояние ещё не создано после смены режима
+
+// Состояние текущего режима. Первый вызов после смены режима создаёт его
+// заново из инициализаторов структуры, поэтому старт режима всегда одинаков.
+template <typename T>
+static T& modeState() {
+  static_assert(sizeof(T) <= sizeof(modeArena), "Mode state does not fit into the arena");
+  if (arenaFresh) {
+    arenaFresh = false;
+    return *new (activeArena) T();
+  }
+  return *reinterpret_cast<T*>(activeArena);
+}
+
+AnimationClock animClock = {0, ANIM_REFERENCE_FRAME_MS};
+static uint32_t lastAnimTick = 0;
+
+static void tickAnimationClock() {
+  uint32_t now = millis();
+  uint32_t delta = now - lastAnimTick;
+  lastAnimTick = now;
+  
+  if (delta > ANIM_MAX_DELTA_MS) {
+    delta = ANIM_MAX_DELTA_MS;
+  }
+  animClock.deltaMs = delta;
+  animClock.ms += delta;
+}
+
+// Продвигает фазу на ratePerFrame единиц за каждые ANIM_REFERENCE_FRAME_MS.
+// Младшие 8 бит фазы - дробная часть, поэтому медленные скорости не теряются
+// при частых кадрах. Возвращает целую часть фазы.
+static uint32_t advancePhase(uint32_t& phase, uint16_t ratePerFrame) {
+  phase += (uint32_t)ratePerFrame * animClock.deltaMs * 256 / ANIM_REFERENCE_FRAME_MS;
+  return phase >> 8;
+}
+
+// Пересчёт "на кадр" величины (затухание) под реальный интервал кадра
+static uint8_t scaleToFrameTime(uint8_t perFrame) {
+  uint32_t scaled = ((uint32_t)perFrame * animClock.deltaMs + ANIM_REFERENCE_FRAME_MS / 2) / ANIM_REFERENCE_FRAME_MS;
+  return scaled > 255 ? 255 : scaled;
+}
+
+const ModeDescriptor& getModeDescriptor(uint8_t mode) {
+  if (mode >= TOTAL_MODES) {
+    return MODE_REGISTRY[1];  // Rainbow Beat, как раньше в default ветке switch
+  }
+  return MODE_REGISTRY[mode];
+}
+
+// Плавный переход между режимами. Оба режима рисуют в свои буферы
+// (juggle дорисовывает собственный прошлый кадр),
+// а в leds[] попадает их смесь. Буферы и копия арены уходящего режима
+// выделяются из кучи только на время перехода.
+struct ModeTransition {
+  uint8_t* block;         // Одно выделение: арена + два буфера, nullptr = перехода нет
+  uint8_t* arena;         // Состояние уходящего режима
+  CRGB* fromLeds;         // Кадр уходящего режима
+  CRGB* toLeds;           // Кадр нового режима
+  uint16_t numLeds;       // Размер буферов
+  uint8_t fromMode;
+  uint32_t startMs;       // animClock.ms в начале перехода
+  uint16_t durationMs;
+  uint8_t amount;         // Доля нового режима в последнем кадре (0-255)
+  bool frozen;            // Не уложились в бюджет: уходящий режим больше не рисуется
+};
+
+FrameStats frameStats = {0, 0, 0};
+
+static ModeTransition transition = {nullptr, nullptr, nullptr, nullptr, 0, 0, 0, 0, 0, false};
+static bool stripDark = true;  // Последний кадр - погашенная лента, переходить не из чего
+
+static void endModeTransition() {
+  free(transition.block);
+  transition.block = nullptr;
+}
+
+static void beginModeTransition(uint8_t fromMode) {
+  endModeTransition();
+  
+  uint16_t numLeds = ledState.numLeds;
+  size_t ledBytes = numLeds * sizeof(CRGB);
+  uint8_t* block = (uint8_t*)malloc(sizeof(modeArena) + 2 * ledBytes);
+  if (block == nullptr) {
+    return;  // Нет памяти - переключаемся мгновенно, как раньше
+  }
+  
+  transition.block = block;
+  transition.arena = block;
+  transition.fromLeds = (CRGB*)(block + sizeof(modeArena));
+  transition.toLeds = transition.fromLeds + numLeds;
+  transition.numLeds = numLeds;
+  transition.fromMode = fromMode;
+  transition.startMs = animClock.ms;
+  transition.durationMs = ledState.transitionMs;
+  transition.amount = 0;
+  transition.frozen = false;
+  
+  // Состояние уходящего режима переезжает в копию, общая арена достаётся новому.
+  // Новый режим стартует с текущей картинки, как при мгновенном переключении.
+  memcpy(transition.arena, modeArena, sizeof(modeArena));
+  memcpy(transition.fromLeds, leds, ledBytes);
+  memcpy(transition.toLeds, leds, ledBytes);
+}
+
+static void renderTransitionFrame(uint8_t mode) {
+  uint32_t frameStart = micros();
+  size_t ledBytes = transition.numLeds * sizeof(CRGB);
+  
+  // Новый режим рисует поверх своего прошлого кадра
+  memcpy(leds, transition.toLeds, ledBytes);
+  getModeDescriptor(mode).render();
+  memcpy(transition.toLeds, leds, ledBytes);
+  
+  // Уходящий режим: своя арена и свои настройки (режимы читают currentMode)
+  if (!transition.frozen) {
+    memcpy(leds, transition.fromLeds, ledBytes);
+    
+    uint8_t savedMode = ledState.currentMode;
+    bool savedFresh = arenaFresh;
+    ledState.currentMode = transition.fromMode;
+    activeArena = transition.arena;
+    arenaFresh = false;
+    
+    getModeDescriptor(transition.fromMode).render();
+    
+    ledState.currentMode = savedMode;
+    activeArena = modeArena;
+    arenaFresh = savedFresh;
+    
+    memcpy(transition.fromLeds, leds, ledBytes);
+  }
+  
+  uint32_t elapsed = animClock.ms - transition.startMs;
+  uint8_t amount = elapsed >= transition.durationMs ? 255 : elapsed * 255 / transition.durationMs;
+  blend(transition.fromLeds, transition.toLeds, leds, transition.numLeds, amount);
+  transition.amount = amount;
+  
+  // Две отрисовки не уложились в бюджет кадра: замораживаем уходящий кадр
+  // и быстро гасим его, чтобы не ронять частоту кадров
+  uint32_t budgetUs = getModeDescriptor(mode).frameMs * 1000UL * FRAME_CPU_BUDGET_PERCENT / 100;
+  if (!transition.frozen && micros() - frameStart > budgetUs) {
+    transition.frozen = true;
+    if (transition.durationMs > elapsed + TRANSITION_SHORT_MS) {
+      transition.durationMs = elapsed + TRANSITION_SHORT_MS;
+    }
+    frameStats.transitionsShortened++;
+  }
+  
+  if (elapsed >= transition.durationMs) {
+    endModeTransition();
+  }
+}
+
+void setModeImmediately(uint8_t mode) {
+  endModeTransition();
+  ledState.currentMode = mode;
+  arenaOwner = mode;
+  arenaFresh = true;
 }
 
 void runMode(uint8_t mode) {
   if (!ledState.power) {
-    FastLED.clear();
-    FastLED.show();
+    // Гасим буфер; showFrame() выведет чёрный кадр один раз и дальше будет пропускать
+    endModeTransition();
+    fill_solid(leds, MAX_LEDS, CRGB::Black);
+    stripDark = true;
     return;
   }
   
-  // Запуск соответствующего режима
-  switch (mode) {
-    case 0: mode_blendwave(); break;
-    case 1: mode_rainbow_beat(); break;
-    case 2: mode_two_sin(); break;
-    case 3: mode_confetti(); break;
-    case 4: mode_fire(); break;
-    case 5: mode_rainbow_march(); break;
-    case 6: mode_plasma(); break;
-    case 7: mode_noise(); break;
-    case 8: mode_juggle(); break;
-    case 9: mode_solid_color(); break;
-    case 10: mode_snowfall(); break;
-    case 11: mode_aurora(); break;
-    case 12: mode_fireflies(); break;
-    
-    default: mode_rainbow_beat(); break;
+  // Смена режима: арена переходит новому режиму и очищается,
+  // старое состояние живёт в копии до конца перехода
+  if (mode != arenaOwner) {
+    if (arenaOwner < TOTAL_MODES && !stripDark && ledState.transitionMs > 0) {
+      beginModeTransition(arenaOwner);
+    } else {
+      endModeTransition();
+    }
+    arenaOwner = mode;
+    arenaFresh = true;
+  }
+  
+  // Количество диодов поменялось на ходу - буферы перехода уже не подходят
+  if (transition.block != nullptr && transition.numLeds != ledState.numLeds) {
+    endModeTransition();
+  }
+  
+  tickAnimationClock();
+  if (transition.block != nullptr) {
+    renderTransitionFrame(mode);
+  } else {
+    getModeDescriptor(mode).render();
+  }
+  stripDark = false;
+}
+
+
+static uint32_t lastFrameHash = 0;
+static uint8_t lastFrameBrightness = 255;  // Она же яркость выходного каскада для showLeds()
+static uint16_t lastFramePowerLimit = 0;
+static uint16_t lastFrameCount = 0;
+static unsigned long lastShowTime = 0;
+static bool frameShownOnce = false;
+static bool lastFrameDithered = false;  // Кадр надо повторить (дизеринг, ограничитель тока)
+
+// FNV-1a по подключённым диодам: хвост outputLeds[] всегда чёрный
+static uint32_t hashFrame() {
+  const uint8_t* data = (const uint8_t*)leds;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < ledState.numLeds * sizeof(CRGB); i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// Яркость режима, который сейчас на ленте. Во время перехода она
+// меняется от уходящего режима к новому вместе с картинкой.
+static uint8_t modeBrightness() {
+  if (arenaOwner >= TOTAL_MODES) {
+    return 255;  // Режим ещё не рисовался (ожидание времени при старте)
+  }
+  uint8_t brightness = ledState.modeSettings[arenaOwner].brightness;
+  if (transition.block != nullptr) {
+    brightness = lerp8by8(ledState.modeSettings[transition.fromMode].brightness, brightness, transition.amount);
+  }
+  return brightness;
+}
+
+// Дизеринг только ночью: на обычной яркости тёмные уровни различимы и без него,
+// а дизерингуемый неподвижный кадр пришлось бы выводить каждый кадр
+static void pushFrame(uint8_t brightness) {
+  setOutputPowerLimit(ledState.powerLimitMa, ledState.numLeds);
+  lastFrameDithered = renderOutput(leds, ledState.numLeds, brightness < LED_DITHER_MAX_BRIGHTNESS);
+  FastLED.show();
+}
+
+void showLeds() {
+  pushFrame(lastFrameBrightness);
+}
+
+bool showFrame() {
+  // Общая яркость и яркость режима сводятся в одну, а вместе с гаммой
+  // и цветокоррекцией - в множители каналов выходного каскада
+  uint8_t brightness = scale8_video(ledState.brightness, modeBrightness());
+  uint32_t hash = hashFrame();
+  unsigned long now = millis();
+  
+  // Дизерингуемый кадр (ночная яркость) меняется на ленте каждый раз, его не пропускаем
+  bool refreshDue = LED_REFRESH_INTERVAL > 0 && now - lastShowTime >= LED_REFRESH_INTERVAL;
+  if (frameShownOnce && hash == lastFrameHash && brightness == lastFrameBrightness &&
+      ledState.powerLimitMa == lastFramePowerLimit && ledState.numLeds == lastFrameCount &&
+      !lastFrameDithered && !refreshDue) {
+    frameStats.skipped++;
+    return false;
   }
+  
+  // show() на 300 диодах держит прерывания ~9 мс, поэтому зря его не зовём
+  setOutputBrightness(brightness);
+  pushFrame(brightness);
+  
+  lastFrameHash = hash;
+  lastFrameBrightness = brightness;
+  lastFramePowerLimit = ledState.powerLimitMa;
+  lastFrameCount = ledState.numLeds;
+  lastShowTime = now;
+  frameShownOnce = true;
+  frameStats.shown++;
+  return true;
 }
 
 // Rainbow Beat - радужная волна
 void mode_rainbow_beat() {
   uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  uint8_t beat = beatsin8(speed / 10, 64, 255);
+  uint8_t beat = beatsin8(speed / 10, 64, 255, animTimebase());
   
   // Scale controls color spacing (1-10)
   uint8_t colorSpacing = map(scale, 0, 255, 1, 10);
   
+  // Встроенная палитра - исходный вид режима: RainbowColors_p и яркость через scale8,
+  // а не радуга hsv2rgb_rainbow из таблицы палитры
+  if (ledState.paletteSource[ledState.currentMode] == PALETTE_BUILTIN) {
+    for (int i = 0; i < ledState.numLeds; i++) {
+      leds[i] = ColorFromPalette(RainbowColors_p, (i * colorSpacing) + beat, beat);
+    }
+    return;
+  }
+  
+  const CRGB* palette = modePalette(ledState.currentMode);
   for (int i = 0; i < ledState.numLeds; i++) {
-    leds[i] = ColorFromPalette(RainbowColors_p, (i * colorSpacing) + beat, beat);
+    leds[i] = palette[(uint8_t)((i * colorSpacing) + beat)];
+    leds[i].nscale8_video(beat);
   }
 }
 
@@ -58,10 +450,13 @@ void mode_blendwave() {
   
   // Scale controls wave density (5-50)
   uint8_t waveDensity = map(scale, 0, 255, 5, 50);
+  const CRGB* palette = modePalette(ledState.currentMode);
+  uint8_t hue = animClock.ms / 20;
+  BeatsinWave wave(speed / 10, waveDensity);
   
   for (int i = 0; i < ledState.numLeds; i++) {
-    uint8_t bright = beatsin8(speed / 10, 0, 255, 0, i * waveDensity);
-    leds[i] = CHSV((millis() / 20) + i * 5, 255, bright);
+    uint8_t bright = wave.next();
+    leds[i] = paletteColor(palette, hue + i * 5, bright);
   }
 }
 
@@ -69,18 +464,18 @@ void mode_blendwave() {
 void mode_two_sin() {
   uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  static uint8_t hue = 0;
-  hue++;
+  uint8_t hue = advancePhase(modeState<TwoSinState>().huePhase, 1);
+  const CRGB* palette = modePalette(ledState.currentMode);
   
   // Scale controls wave frequency (2-20)
   uint8_t waveFreq = map(scale, 0, 255, 2, 20);
+  BeatsinWave wave1(speed / 15, waveFreq);
+  BeatsinWave wave2(speed / 20, waveFreq + 2, 128);
   
   for (int i = 0; i < ledState.numLeds; i++) {
-    uint8_t bright1 = beatsin8(speed / 15, 0, 255, 0, i * waveFreq);
-    uint8_t bright2 = beatsin8(speed / 20, 0, 255, 0, i * (waveFreq + 2) + 128);
-    uint8_t bright = (bright1 + bright2) / 2;
+    uint8_t bright = (wave1.next() + wave2.next()) / 2;
     
-    leds[i] = CHSV(hue + i * 3, 255, bright);
+    leds[i] = paletteColor(palette, hue + i * 3, bright);
   }
 }
 
@@ -89,9 +484,10 @@ void mode_confetti() {
   uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
   
+  ConfettiState& state = modeState<ConfettiState>();
+  
   // Speed controls fade rate (1-30)
   uint8_t fadeAmount = map(speed, 0, 255, 1, 30);
-  fadeToBlackBy(leds, ledState.numLeds, fadeAmount);
   
   // Scale controls number of confetti particles (1-8)
   uint8_t numConfetti = map(scale, 0, 255, 1, 8);
@@ -99,44 +495,30 @@ void mode_confetti() {
   // Speed also affects spawn probability
   uint8_t spawnChance = map(speed, 0, 255, 50, 255);
   
-  for (uint8_t i = 0; i < numConfetti; i++) {
-    if (random8() < spawnChance) {
-      int pos = random16(ledState.numLeds);
-      // Use direct assignment to prevent brightness overflow flashes
-      leds[pos] = CHSV(random8(), 200, 255);
+  // Шаг симуляции = опорный кадр: затухание и появление как раньше при 50 FPS
+  uint8_t alpha = advanceSimulation(state.sim, ANIM_REFERENCE_FRAME_MS, [&]() {
+    state.particles.update();
+    for (uint8_t i = 0; i < numConfetti; i++) {
+      if (poolRandom8() < spawnChance) {
+        state.particles.spawn(poolRandom16(ledState.numLeds), poolRandom8(), 200, 255, fadeAmount);
+      }
     }
-  }
+  });
+  
+  // Максимум вместо сложения: наложения не дают белых вспышек
+  fill_solid(leds, ledState.numLeds, CRGB::Black);
+  state.particles.draw(leds, ledState.numLeds, alpha, PARTICLE_BLEND_MAX, false);
 }
 
 // Fire - огонь
-void mode_fire() {
-  static byte heat[MAX_LEDS];
-  static unsigned long lastUpdate = 0;
-  
-  uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
-  uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  
-  // Speed controls update rate (delay between frames: 10-100ms)
-  uint8_t updateDelay = map(speed, 0, 255, 100, 10);
-  
-  unsigned long now = millis();
-  if (now - lastUpdate < updateDelay) {
-    // Just redraw without updating heat
-    for (int j = 0; j < ledState.numLeds; j++) {
-      CRGB color = HeatColor(heat[j]);
-      leds[j] = color;
-    }
-    return;
-  }
-  lastUpdate = now;
-  
-  // Scale controls fire intensity
-  uint8_t cooling = map(scale, 0, 255, 20, 100);   // Lower scale = calmer fire
-  uint8_t sparking = map(scale, 0, 255, 50, 200);  // Lower scale = fewer sparks
+// Один шаг симуляции: охлаждение, распространение тепла вверх и искры
+static void fireStep(FireState& state, uint8_t cooling, uint8_t sparking) {
+  byte* heat = state.heat;
+  memcpy(state.prevHeat, heat, ledState.numLeds);
   
   // Охлаждение
   for (int i = 0; i < ledState.numLeds; i++) {
-    heat[i] = qsub8(heat[i], random8(0, ((cooling * 10) / ledState.numLeds) + 2));
+    heat[i] = qsub8(heat[i], poolRandom8(0, ((cooling * 10) / ledState.numLeds) + 2));
   }
   
   // Распространение
@@ -145,57 +527,83 @@ void mode_fire() {
   }
   
   // Искры
-  if (random8() < sparking) {
-    int y = random8(7);
-    heat[y] = qadd8(heat[y], random8(160, 255));
+  if (poolRandom8() < sparking) {
+    int y = poolRandom8(7);
+    heat[y] = qadd8(heat[y], poolRandom8(160, 255));
   }
+}
+
+void mode_fire() {
+  FireState& state = modeState<FireState>();
+  
+  uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
+  uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
+  
+  // Speed controls simulation step (10-100ms)
+  uint8_t stepMs = map(speed, 0, 255, 100, 10);
+  
+  // Scale controls fire intensity
+  uint8_t cooling = map(scale, 0, 255, 20, 100);   // Lower scale = calmer fire
+  uint8_t sparking = map(scale, 0, 255, 50, 200);  // Lower scale = fewer sparks
   
-  // Отображение
+  uint8_t alpha = advanceSimulation(state.sim, stepMs, [&]() {
+    fireStep(state, cooling, sparking);
+  });
+  
+  // Отображение: тепло между двумя последними шагами
   for (int j = 0; j < ledState.numLeds; j++) {
-    CRGB color = HeatColor(heat[j]);
-    leds[j] = color;
+    leds[j] = HeatColor(lerp8by8(state.prevHeat[j], state.heat[j], alpha));
   }
 }
 
 // Rainbow March - радужный марш
 void mode_rainbow_march() {
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  static uint8_t hue = 0;
-  hue += ledState.modeSettings[ledState.currentMode].speed / 50;
+  uint8_t hue = advancePhase(modeState<RainbowMarchState>().huePhase,
+                             ledState.modeSettings[ledState.currentMode].speed / 50);
   
   // Scale controls color spacing (1-20)
   uint8_t colorSpacing = map(scale, 0, 255, 1, 20);
+  const CRGB* palette = modePalette(ledState.currentMode);
   
-  fill_rainbow(leds, ledState.numLeds, hue, colorSpacing);
+  for (int i = 0; i < ledState.numLeds; i++) {
+    leds[i] = palette[hue];
+    hue += colorSpacing;
+  }
 }
 
 // Plasma - плазма
 void mode_plasma() {
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  static uint8_t offset = 0;
-  offset++;
+  PlasmaState& state = modeState<PlasmaState>();
+  uint8_t offset = advancePhase(state.offsetPhase, 1);
   
   // Scale controls noise scale (10-100)
   uint8_t noiseScale = map(scale, 0, 255, 10, 100);
+  const CRGB* palette = modePalette(ledState.currentMode);
+  state.noise.update(0, noiseScale, offset * 3, ledState.numLeds);
   
   for (int i = 0; i < ledState.numLeds; i++) {
-    uint8_t bright = inoise8(i * noiseScale, offset * 3);
-    leds[i] = CHSV((i * 7) + offset, 255, bright);
+    uint8_t bright = state.noise.next();
+    leds[i] = paletteColor(palette, (i * 7) + offset, bright);
   }
 }
 
 // Noise - шум
 void mode_noise() {
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  static uint16_t x = 0;
-  x += ledState.modeSettings[ledState.currentMode].speed;
+  uint16_t x = advancePhase(modeState<NoiseState>().xPhase,
+                            ledState.modeSettings[ledState.currentMode].speed);
   
   // Scale controls noise density (50-300)
   uint16_t noiseDensity = map(scale, 0, 255, 50, 300);
+  const CRGB* palette = modePalette(ledState.currentMode);
   
+  // Без NoiseRow: пиксели реже узлов его сетки, а строка сдвигается каждый
+  // кадр, так что кэшировать нечего
   for (int i = 0; i < ledState.numLeds; i++) {
     uint8_t bright = inoise8(x + i * noiseDensity);
-    leds[i] = CHSV((i * 8) + (x / 100), 255, bright);
+    leds[i] = paletteColor(palette, (i * 8) + (x / 100), bright);
   }
 }
 
@@ -204,7 +612,7 @@ void mode_juggle() {
   uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
   
-  fadeToBlackBy(leds, ledState.numLeds, 20);
+  fadeToBlackBy(leds, ledState.numLeds, scaleToFrameTime(20));
   
   // Scale controls number of juggling dots (1-16)
   uint8_t numDots = map(scale, 0, 255, 1, 16);
@@ -213,14 +621,14 @@ void mode_juggle() {
   for (int i = 0; i < numDots; i++) {
     // Speed controls BPM (beats per minute: 10-60)
     uint8_t bpm = map(speed, 0, 255, 10, 60);
-    leds[beatsin16(bpm + i * 2, 0, ledState.numLeds - 1)] |= CHSV(dothue, 200, 255);
+    leds[beatsin16(bpm + i * 2, 0, ledState.numLeds - 1, animTimebase())] |= CHSV(dothue, 200, 255);
     dothue += (256 / numDots);  // Distribute colors evenly
   }
 }
 
-// Solid Color - один цвет
+// Solid Color - один цвет (color1 из настроек режима)
 void mode_solid_color() {
-  CRGB color = CRGB::White;
+  CRGB color = ledState.modeSettings[ledState.currentMode].color1;
   fill_solid(leds, ledState.numLeds, color);
 }
 
@@ -235,51 +643,47 @@ void mode_snowfall() {
   // Скорость падения (интервал в мс между шагами)
   uint8_t fallSpeed = map(speed, 0, 255, 80, 8);
   
-  // Статический массив для хранения позиций снежинок (яркость каждого LED)
-  static uint8_t snow[MAX_LEDS];
-  static unsigned long lastUpdate = 0;
+  SnowfallState& state = modeState<SnowfallState>();
+  ScrollBuffer& snow = state.snow;
   
-  unsigned long now = millis();
-  
-  // Обновление позиций снежинок
-  if (now - lastUpdate >= fallSpeed) {
-    lastUpdate = now;
-    
+  // Обновление позиций снежинок: шаг каждые fallSpeed мс часов анимации
+  advanceSimulation(state.sim, fallSpeed, [&]() {
     // Сдвигаем все снежинки вниз (к большему индексу)
-    for (int i = ledState.numLeds - 1; i > 0; i--) {
-      snow[i] = snow[i - 1];
-    }
+    snow.scroll();
     
     // Генерируем новые снежинки в начале ленты
     // Случайная генерация с учётом плотности
-    if (random8() < density * 12) {
-      snow[0] = random8(180, 255);  // Яркость новой снежинки
+    if (poolRandom8() < density * 12) {
+      snow[0] = poolRandom8(180, 255);  // Яркость новой снежинки
     } else {
       snow[0] = 0;
     }
-  }
+  });
   
-  // Отрисовка снежинок с мерцанием
+  // Отрисовка снежинок с мерцанием: CHSV пишутся в leds[] и переводятся на месте
+  CHSV* hsv = (CHSV*)leds;
   for (int i = 0; i < ledState.numLeds; i++) {
-    if (snow[i] > 0) {
+    uint8_t flake = snow[i];
+    if (flake > 0) {
       // Мерцание: добавляем случайное изменение яркости
-      uint8_t twinkle = snow[i];
-      if (random8() < 60) {
-        twinkle = qadd8(twinkle, random8(20, 50));  // Вспышка
+      uint8_t twinkle = flake;
+      if (poolRandom8() < 60) {
+        twinkle = qadd8(twinkle, poolRandom8(20, 50));  // Вспышка
       }
-      if (random8() < 40) {
-        twinkle = qsub8(twinkle, random8(10, 30));  // Приглушение
+      if (poolRandom8() < 40) {
+        twinkle = qsub8(twinkle, poolRandom8(10, 30));  // Приглушение
       }
       
       // Цвет снежинки: белый с лёгким голубым оттенком
       // Hue 160-180 = голубой, низкая насыщенность = близко к белому
-      uint8_t hue = 160 + random8(20);      // Голубоватый оттенок
-      uint8_t sat = random8(0, 80);         // Низкая насыщенность (ближе к белому)
-      leds[i] = CHSV(hue, sat, twinkle);
+      uint8_t hue = 160 + poolRandom8(20);         // Голубоватый оттенок
+      uint8_t saturation = poolRandom8(0, 80);     // Низкая насыщенность (ближе к белому)
+      hsv[i] = CHSV(hue, saturation, twinkle);
     } else {
-      leds[i] = CRGB::Black;
+      hsv[i] = CHSV(0, 0, 0);               // Чёрный
     }
   }
+  hsv2rgbStrip(leds, hsv, ledState.numLeds);
 }
 
 // Aurora Borealis - Северное сияние
@@ -288,17 +692,16 @@ void mode_aurora() {
   uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
   uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
   
-  // Статические переменные для плавной анимации
-  static uint16_t auroraTime = 0;
-  static uint8_t baseHue = 96;  // Начинаем с зелёного (характерный цвет сияния)
+  AuroraState& state = modeState<AuroraState>();
+  uint8_t& baseHue = state.baseHue;
   
   // Speed контролирует скорость движения волн (1-10)
   uint8_t waveSpeed = map(speed, 0, 255, 1, 10);
-  auroraTime += waveSpeed;
+  uint16_t auroraTime = advancePhase(state.timePhase, waveSpeed);
   
   // Медленное изменение базового оттенка для разнообразия
-  if (random8() < 3) {
-    baseHue = baseHue + random8(3) - 1;  // Случайный дрейф ±1
+  if (poolRandom8() < 3) {
+    baseHue = baseHue + poolRandom8(3) - 1;  // Случайный дрейф ±1
     // Ограничиваем палитру сияния: зелёный (96) - голубой (128) - фиолетовый (192)
     if (baseHue < 80) baseHue = 80;
     if (baseHue > 200) baseHue = 200;
@@ -306,7 +709,10 @@ void mode_aurora() {
   
   // Scale контролирует "ширину" волн сияния (10-50)
   uint8_t waveWidth = map(scale, 0, 255, 10, 50);
+  state.brightNoise.update(0, 30, auroraTime * 2, ledState.numLeds);
+  state.hueNoise.update(0, 20, auroraTime / 2, ledState.numLeds);
   
+  CHSV* hsv = (CHSV*)leds;  // Переводится в RGB на месте (hsv2rgbStrip)
   for (int i = 0; i < ledState.numLeds; i++) {
     // Создаём несколько накладывающихся волн с разными частотами
     // Это имитирует слоистую структуру полярного сияния
@@ -324,7 +730,7 @@ void mode_aurora() {
     uint16_t combinedWave = ((uint16_t)wave1 * 3 + (uint16_t)wave2 * 2 + (uint16_t)wave3) / 6;
     
     // Добавляем Perlin noise для органичного мерцания
-    uint8_t noise = inoise8(i * 30, auroraTime * 2);
+    uint8_t noise = state.brightNoise.next();
     
     // Яркость зависит от комбинированной волны и шума
     uint8_t brightness = (combinedWave * noise) / 256;
@@ -340,36 +746,37 @@ void mode_aurora() {
     
     // Цвет варьируется вдоль ленты с добавлением шума
     // Создаём характерные цвета сияния: зелёный -> голубой -> фиолетовый
-    uint8_t hueNoise = inoise8(i * 20, auroraTime / 2);
+    uint8_t hueNoise = state.hueNoise.next();
     uint8_t hue = baseHue + (hueNoise / 4) - 32;  // Вариация ±32 от базового
     
     // Насыщенность высокая, но с небольшой вариацией
     uint8_t saturation = 200 + (noise / 8);  // 200-231
     
     // Добавляем случайные "вспышки" - характерная черта сияния
-    if (random8() < 5 && brightness > 100) {
+    if (poolRandom8() < 5 && brightness > 100) {
       brightness = qadd8(brightness, 50);  // Случайная вспышка
       saturation = qsub8(saturation, 40);  // Вспышки чуть белее
     }
     
-    leds[i] = CHSV(hue, saturation, brightness);
+    hsv[i] = CHSV(hue, saturation, brightness);
   }
+  hsv2rgbStrip(leds, hsv, ledState.numLeds);
   
   // Добавляем редкие "занавески" - вертикальные полосы повышенной яркости
-  static uint8_t curtainPos = 0;
-  static uint8_t curtainWidth = 5;
-  static unsigned long lastCurtain = 0;
-  
-  if (millis() - lastCurtain > 2000) {  // Новая занавеска каждые 2 секунды
-    if (random8() < 30) {  // 12% шанс появления
-      curtainPos = random8(ledState.numLeds);
-      curtainWidth = random8(3, 10);
-      lastCurtain = millis();
+  uint8_t& curtainPos = state.curtainPos;
+  uint8_t& curtainWidth = state.curtainWidth;
+  uint32_t& lastCurtain = state.lastCurtain;
+  
+  if (animClock.ms - lastCurtain > 2000) {  // Новая занавеска каждые 2 секунды
+    if (poolRandom8() < 30) {  // 12% шанс появления
+      curtainPos = poolRandom8(ledState.numLeds);
+      curtainWidth = poolRandom8(3, 10);
+      lastCurtain = animClock.ms;
     }
   }
   
   // Рисуем "занавеску" с затуханием
-  uint8_t curtainAge = (millis() - lastCurtain) / 10;
+  uint32_t curtainAge = (animClock.ms - lastCurtain) / 10;
   if (curtainAge < 100) {
     uint8_t curtainBright = 255 - curtainAge * 2;
     for (int j = 0; j < curtainWidth && (curtainPos + j) < ledState.numLeds; j++) {
@@ -383,186 +790,110 @@ void mode_aurora() {
 // Fireflies - Светлячки
 // Имитация волшебных светлячков: точки плавно загораются и угасают в случайных местах
 // Новогодняя палитра: красные, зелёные, золотые и белые искорки
-void mode_fireflies() {
-  uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
-  uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
-  
-  // Максимальное количество одновременных светлячков (5-30)
-  uint8_t maxFireflies = map(scale, 0, 255, 5, 30);
-  
-  // Структура для хранения состояния каждого светлячка
-  // phase: 0=неактивен, 1-127=разгорается, 128-255=угасает
-  static struct {
-    uint16_t pos;      // Позиция на ленте
-    uint8_t phase;     // Фаза жизненного цикла (0=мёртв)
-    uint8_t hue;       // Индивидуальный оттенок
-    uint8_t sat;       // Насыщенность (для белых искорок)
-    uint8_t maxBright; // Максимальная яркость этого светлячка
-    uint8_t speed;     // Индивидуальная скорость (разные светлячки мигают с разной скоростью)
-  } fireflies[30];
-  
-  static unsigned long lastUpdate = 0;
-  static bool initialized = false;
+
+// Один шаг симуляции: фазы, появление новых светлячков и вспышки
+static void firefliesStep(FirefliesState& state, uint8_t maxFireflies, uint8_t speed, uint8_t stepMs) {
+  ParticlePool& particles = state.particles;
   
   // Новогодние цвета (hue): красный=0, зелёный=96, золотой=32
   // Массив новогодних оттенков
   static const uint8_t xmasHues[] = {0, 0, 96, 96, 32, 32, 160};  // красный, красный, зелёный, зелёный, золотой, золотой, голубой
   static const uint8_t numXmasHues = 7;
   
-  // Инициализация при первом запуске
-  if (!initialized) {
-    for (int i = 0; i < 30; i++) {
-      fireflies[i].phase = 0;
-      fireflies[i].pos = 0;
-    }
-    initialized = true;
-  }
+  particles.update();
   
-  // Скорость обновления анимации (5-30ms)
-  uint8_t updateInterval = map(speed, 0, 255, 30, 5);
+  // Каждое свободное место может занять новый светлячок
+  // Вероятность появления зависит от speed (чаще при высокой скорости)
+  uint8_t spawnChance = map(speed, 0, 255, 5, 40);
+  uint8_t freeSlots = maxFireflies > particles.active ? maxFireflies - particles.active : 0;
   
-  unsigned long now = millis();
-  if (now - lastUpdate < updateInterval) {
-    // Просто перерисовываем без обновления состояния
-    fill_solid(leds, ledState.numLeds, CRGB::Black);
-    for (int i = 0; i < maxFireflies; i++) {
-      if (fireflies[i].phase > 0 && fireflies[i].pos < ledState.numLeds) {
-        uint8_t brightness;
-        if (fireflies[i].phase <= 127) {
-          // Разгорается: 0->127 соответствует 0->255 яркости (но макс = maxBright)
-          brightness = ease8InOutCubic(fireflies[i].phase * 2);
-          brightness = (brightness * fireflies[i].maxBright) / 255;
-        } else {
-          // Угасает: 128->255 соответствует 255->0 яркости
-          brightness = ease8InOutCubic((255 - fireflies[i].phase) * 2);
-          brightness = (brightness * fireflies[i].maxBright) / 255;
-        }
-        leds[fireflies[i].pos] = CHSV(fireflies[i].hue, fireflies[i].sat, brightness);
-        
-        // Добавляем легкое свечение на соседние пиксели (ореол)
-        if (brightness > 50) {
-          uint8_t glowBright = brightness / 3;  // Усилили ореол
-          uint8_t glowSat = fireflies[i].sat > 50 ? fireflies[i].sat - 30 : 0;
-          if (fireflies[i].pos > 0) {
-            leds[fireflies[i].pos - 1] += CHSV(fireflies[i].hue, glowSat, glowBright);
-          }
-          if (fireflies[i].pos < ledState.numLeds - 1) {
-            leds[fireflies[i].pos + 1] += CHSV(fireflies[i].hue, glowSat, glowBright);
-          }
-        }
-      }
+  for (uint8_t i = 0; i < freeSlots; i++) {
+    if (poolRandom8() >= spawnChance) {
+      continue;
     }
-    return;
-  }
-  lastUpdate = now;
-  
-  // Очищаем ленту
-  fill_solid(leds, ledState.numLeds, CRGB::Black);
-  
-  // Обновляем состояние каждого светлячка
-  for (int i = 0; i < maxFireflies; i++) {
-    if (fireflies[i].phase > 0) {
-      // Светлячок активен - продвигаем фазу
-      uint8_t phaseStep = 1 + fireflies[i].speed / 64;  // Индивидуальная скорость
-      
-      if (fireflies[i].phase <= 127) {
-        // Фаза разгорания
-        fireflies[i].phase += phaseStep;
-        if (fireflies[i].phase > 127) fireflies[i].phase = 128;  // Переход к угасанию
-      } else if (fireflies[i].phase < 255) {
-        // Фаза угасания
-        fireflies[i].phase += phaseStep;
-        if (fireflies[i].phase < 128) fireflies[i].phase = 255;  // Overflow protection
-      }
-      
-      // Светлячок полностью угас
-      if (fireflies[i].phase >= 254) {
-        fireflies[i].phase = 0;
-      }
-      
-      // Рисуем светлячка
-      if (fireflies[i].phase > 0 && fireflies[i].pos < ledState.numLeds) {
-        uint8_t brightness;
-        if (fireflies[i].phase <= 127) {
-          // Разгорается с кубической интерполяцией для плавности
-          brightness = ease8InOutCubic(fireflies[i].phase * 2);
-          brightness = (brightness * fireflies[i].maxBright) / 255;
-        } else {
-          // Угасает
-          brightness = ease8InOutCubic((255 - fireflies[i].phase) * 2);
-          brightness = (brightness * fireflies[i].maxBright) / 255;
-        }
-        
-        // Основная точка светлячка
-        leds[fireflies[i].pos] = CHSV(fireflies[i].hue, fireflies[i].sat, brightness);
-        
-        // Ореол свечения на соседних пикселях для магического эффекта
-        if (brightness > 50) {
-          uint8_t glowBright = brightness / 3;  // Усилили ореол
-          uint8_t glowSat = fireflies[i].sat > 50 ? fireflies[i].sat - 30 : 0;
-          if (fireflies[i].pos > 0) {
-            leds[fireflies[i].pos - 1] += CHSV(fireflies[i].hue, glowSat, glowBright);
-          }
-          if (fireflies[i].pos < ledState.numLeds - 1) {
-            leds[fireflies[i].pos + 1] += CHSV(fireflies[i].hue, glowSat, glowBright);
-          }
-        }
-      }
+    
+    uint16_t pos = poolRandom16(ledState.numLeds);
+    uint8_t hue, sat;
+    
+    // Новогодняя палитра!
+    uint8_t colorChoice = poolRandom8(100);
+    if (colorChoice < 15) {
+      // 15% - белые/серебристые искорки (очень красиво!)
+      hue = poolRandom8();  // Любой оттенок, но...
+      sat = poolRandom8(0, 30);  // Почти белый!
     } else {
-      // Светлячок неактивен - может появиться новый
-      // Вероятность появления зависит от speed (чаще при высокой скорости)
-      uint8_t spawnChance = map(speed, 0, 255, 5, 40);
-      
-      if (random8() < spawnChance) {
-        // Создаём нового светлячка
-        fireflies[i].pos = random16(ledState.numLeds);
-        fireflies[i].phase = 1;  // Начинаем разгораться
-        
-        // Новогодняя палитра!
-        uint8_t colorChoice = random8(100);
-        if (colorChoice < 15) {
-          // 15% - белые/серебристые искорки (очень красиво!)
-          fireflies[i].hue = random8();  // Любой оттенок, но...
-          fireflies[i].sat = random8(0, 30);  // Почти белый!
-        } else {
-          // 85% - новогодние цвета
-          uint8_t hueIdx = random8(numXmasHues);
-          fireflies[i].hue = xmasHues[hueIdx] + random8(16) - 8;  // Небольшая вариация ±8
-          fireflies[i].sat = 255;  // Максимальная насыщенность!
-        }
-        
-        // Случайная максимальная яркость (разные светлячки - разная интенсивность)
-        fireflies[i].maxBright = random8(180, 255);  // Повысили минимум
-        
-        // Случайная скорость мигания
-        fireflies[i].speed = random8(64, 255);
-      }
+      // 85% - новогодние цвета
+      uint8_t hueIdx = poolRandom8(numXmasHues);
+      hue = xmasHues[hueIdx] + poolRandom8(16) - 8;  // Небольшая вариация ±8
+      sat = 255;  // Максимальная насыщенность!
     }
+    
+    // Случайная максимальная яркость (разные светлячки - разная интенсивность)
+    uint8_t maxBright = poolRandom8(180, 255);  // Повысили минимум
+    
+    // Случайная скорость мигания (разные светлячки мигают с разной скоростью)
+    uint8_t phaseStep = 1 + poolRandom8(64, 255) / 64;
+    
+    particles.spawn(pos, hue, sat, maxBright, phaseStep);
   }
   
   // Добавляем редкие "вспышки" - когда светлячок особенно ярко мигает
   // Это создаёт эффект "общения" между светлячками
-  static unsigned long lastFlash = 0;
-  if (now - lastFlash > 400) {  // Чуть чаще вспышки
-    if (random8() < 20) {  // ~8% шанс
-      // Находим активного светлячка и делаем его ярче
-      for (int i = 0; i < maxFireflies; i++) {
-        if (fireflies[i].phase > 50 && fireflies[i].phase < 200) {
-          // Вспышка! Добавляем яркость
-          uint16_t pos = fireflies[i].pos;
-          if (pos < ledState.numLeds) {
-            // Яркая белая вспышка с цветным ядром
-            leds[pos] = CHSV(fireflies[i].hue, fireflies[i].sat, 255);
-            // Расширенный белый ореол при вспышке
-            if (pos > 0) leds[pos - 1] = CHSV(fireflies[i].hue, fireflies[i].sat / 2, 180);
-            if (pos > 1) leds[pos - 2] += CHSV(fireflies[i].hue, fireflies[i].sat / 3, 90);
-            if (pos < ledState.numLeds - 1) leds[pos + 1] = CHSV(fireflies[i].hue, fireflies[i].sat / 2, 180);
-            if (pos < ledState.numLeds - 2) leds[pos + 2] += CHSV(fireflies[i].hue, fireflies[i].sat / 3, 90);
-          }
-          lastFlash = now;
-          break;
-        }
+  state.flash = -1;
+  if (state.sinceFlashMs <= 400) {
+    state.sinceFlashMs += stepMs;
+  } else if (poolRandom8() < 20) {  // ~8% шанс, чуть чаще вспышки
+    // Находим активного светлячка и делаем его ярче
+    for (uint8_t i = 0; i < PARTICLE_CAPACITY; i++) {
+      if (particles.phase[i] > 50 && particles.phase[i] < 200) {
+        state.flash = i;
+        state.sinceFlashMs = 0;
+        break;
       }
     }
   }
 }
+
+void mode_fireflies() {
+  uint8_t speed = ledState.modeSettings[ledState.currentMode].speed;
+  uint8_t scale = ledState.modeSettings[ledState.currentMode].scale;
+  
+  // Светлячков на 100 LED (5-30), на длинной ленте пропорционально больше
+  uint16_t maxFireflies = map(scale, 0, 255, 5, 30);
+  if (ledState.numLeds > 100) {
+    maxFireflies = maxFireflies * ledState.numLeds / 100;
+  }
+  if (maxFireflies > PARTICLE_CAPACITY) {
+    maxFireflies = PARTICLE_CAPACITY;
+  }
+  
+  FirefliesState& state = modeState<FirefliesState>();
+  const ParticlePool& particles = state.particles;
+  
+  // Шаг симуляции (5-30ms)
+  uint8_t stepMs = map(speed, 0, 255, 30, 5);
+  
+  uint8_t alpha = advanceSimulation(state.sim, stepMs, [&]() {
+    firefliesStep(state, maxFireflies, speed, stepMs);
+  });
+  
+  // Светлячки с ореолом на соседних пикселях для магического эффекта
+  fill_solid(leds, ledState.numLeds, CRGB::Black);
+  particles.draw(leds, ledState.numLeds, alpha, PARTICLE_BLEND_ADD, true);
+  
+  // Вспышка держится до следующего шага симуляции
+  if (state.flash >= 0) {
+    uint16_t pos = particles.pos[state.flash];
+    uint8_t hue = particles.hue[state.flash];
+    uint8_t sat = particles.sat[state.flash];
+    if (pos < ledState.numLeds) {
+      // Яркая белая вспышка с цветным ядром
+      leds[pos] = CHSV(hue, sat, 255);
+      // Расширенный белый ореол при вспышке
+      if (pos > 0) leds[pos - 1] = CHSV(hue, sat / 2, 180);
+      if (pos > 1) leds[pos - 2] += CHSV(hue, sat / 3, 90);
+      if (pos < ledState.numLeds - 1) leds[pos + 1] = CHSV(hue, sat / 2, 180);
+      if (pos < ledState.numLeds - 2) leds[pos + 2] += CHSV(hue, sat / 3, 90);
+    }
+  }
+}
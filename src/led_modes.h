@@ -12,6 +12,136 @@ void initLEDs();
 // Запуск режима
 void runMode(uint8_t mode);
 
+// Сделать mode текущим без плавного перехода: следующий runMode() рисует
+// его с чистой ареной (возврат живого режима после бенчмарка)
+void setModeImmediately(uint8_t mode);
+
+// Опорный интервал кадра: скорости режимов подобраны под 50 FPS
+#define ANIM_REFERENCE_FRAME_MS 20
+// Максимальный шаг часов за кадр: после паузы или зависания анимация не прыгает
+#define ANIM_MAX_DELTA_MS 250
+// Минимум шагов симуляции за кадр у режимов с фиксированным шагом (огонь, светлячки).
+// Настоящий предел - simMaxSteps(): столько шагов, сколько нужно кадру
+// в FRAME_MAX_INTERVAL_MS, но не меньше этого числа
+#define SIM_MAX_STEPS_PER_FRAME 4
+
+// Общие часы анимации. Обновляются в runMode() перед отрисовкой кадра,
+// поэтому скорость анимации не зависит от частоты кадров.
+struct AnimationClock {
+  uint32_t ms;       // Время анимации (мс), сумма deltaMs
+  uint16_t deltaMs;  // Время с прошлого кадра (мс), не больше ANIM_MAX_DELTA_MS
+};
+
+extern AnimationClock animClock;
+
+// Отсчёт для beat8()/beatsin8()/beatsin16() FastLED (параметр timebase):
+// с ним волны идут по animClock.ms, а не по millis()
+inline uint32_t animTimebase() {
+  return millis() - animClock.ms;
+}
+
+// Часы симуляции режима с фиксированным шагом (см. advanceSimulation)
+struct SimClock {
+  uint16_t accumMs = 0;  // Время анимации, ещё не отданное шагам
+  bool started = false;
+};
+
+// Предел шагов за кадр: кадр до FRAME_MAX_INTERVAL_MS (просадка FPS под
+// нагрузкой) отрабатывается целиком, и симуляция не отстаёт от часов
+inline uint8_t simMaxSteps(uint8_t stepMs) {
+  uint8_t steps = FRAME_MAX_INTERVAL_MS / stepMs + 1;
+  return steps > SIM_MAX_STEPS_PER_FRAME ? steps : SIM_MAX_STEPS_PER_FRAME;
+}
+
+// Симуляция с фиксированным шагом для режимов с состоянием (огонь, светлячки).
+// Выполняет step() столько раз, сколько шагов по stepMs набралось по часам
+// анимации, поэтому скорость симуляции не зависит от частоты кадров, а её цена
+// за кадр ограничена simMaxSteps(). Возвращает положение кадра между
+// двумя последними шагами (0-255): режим рисует состояние, интерполированное
+// между ними, и может рисовать на любой частоте кадров.
+template <typename StepFunc>
+uint8_t advanceSimulation(SimClock& clock, uint8_t stepMs, StepFunc step) {
+  if (stepMs == 0) {
+    stepMs = 1;
+  }
+  if (!clock.started) {
+    clock.started = true;
+    clock.accumMs = stepMs;  // Первый шаг - сразу
+  } else {
+    clock.accumMs += animClock.deltaMs;
+  }
+  
+  uint8_t maxSteps = simMaxSteps(stepMs);
+  uint8_t steps = 0;
+  while (clock.accumMs >= stepMs) {
+    if (steps == maxSteps) {
+      // Кадр дольше FRAME_MAX_INTERVAL_MS (зависание, запись во флеш):
+      // не догоняем, лишнее время отбрасываем
+      clock.accumMs %= stepMs;
+      break;
+    }
+    clock.accumMs -= stepMs;
+    step();
+    steps++;
+  }
+  return clock.accumMs * 256 / stepMs;
+}
+
+// Статистика вывода кадров (для /api/debug)
+struct FrameStats {
+  uint32_t shown;    // Кадров отправлено на ленту
+  uint32_t skipped;  // Кадров пропущено: leds[] и яркость не изменились
+  uint32_t transitionsShortened;  // Переходов, не уложившихся в бюджет кадра
+};
+
+extern FrameStats frameStats;
+
+// Вывод leds[] на ленту через выходной каскад (led_output.h) без проверок.
+// Для заставок в setup() и бенчмарка; FastLED.show() напрямую выводит старый кадр.
+void showLeds();
+
+// Вывод кадра на ленту, только если он отличается от уже показанного.
+// Яркость вывода = общая яркость × яркость режима (ModeSettings::brightness).
+// Раз в LED_REFRESH_INTERVAL кадр повторяется даже без изменений.
+// Возвращает true, если FastLED.show() был вызван.
+bool showFrame();
+
+// Волна beatsin8(bpm, 0, 255, animTimebase(), phaseOffset + i * step) вдоль ленты.
+// beat8() читает часы один раз при создании, next() возвращает значение
+// для очередного пикселя и сдвигает фазу на step.
+struct BeatsinWave {
+  uint8_t phase;
+  uint8_t step;
+  
+  BeatsinWave(accum88 bpm, uint8_t step, uint8_t phaseOffset = 0)
+    : phase(beat8(bpm, animTimebase()) + phaseOffset), step(step) {}
+  
+  uint8_t next() {
+    uint8_t value = sin8(phase);
+    phase += step;
+    return value;
+  }
+};
+
+typedef void (*ModeRenderFunc)();
+
+// Описание режима. Добавление режима = функция + строка в MODE_REGISTRY (led_modes.cpp)
+struct ModeDescriptor {
+  ModeRenderFunc render;   // Отрисовка одного кадра в leds[]
+  const char* name;        // Название для UI и логов
+  uint8_t defaultSpeed;    // Скорость по умолчанию (0-255)
+  uint8_t defaultScale;    // Масштаб по умолчанию (0-255)
+  uint32_t defaultColor1;  // color1 по умолчанию (0xRRGGBB или CRGB::...)
+  uint8_t frameMs;         // Целевой интервал кадра (мс), он же бюджет кадра
+  uint16_t stateSize;      // Размер состояния режима (байт), 0 = без состояния
+};
+
+// Реестр режимов: индекс = номер режима в API и EEPROM
+extern const ModeDescriptor MODE_REGISTRY[TOTAL_MODES];
+
+// Описание режима с защитой от неверного номера (мусор в EEPROM)
+const ModeDescriptor& getModeDescriptor(uint8_t mode);
+
 // Базовые режимы (упрощенные версии из референса)
 void mode_blendwave();
 void mode_rainbow_beat();
@@ -0,0 +1,137 @@
+#include "led_output.h"
+
+CRGB outputLeds[MAX_LEDS];
+PowerStats powerStats = {0, 0, 255, 0};
+
+// Гамма в 16 битах: младшие биты не теряются при низкой яркости
+static uint16_t gammaLut[256];
+
+// Яркость × коррекция для каждого канала, 0-65535. Уровень канала -
+// gammaLut[v] × scale >> 16, 8.8 с фиксированной точкой; дробная часть - то,
+// что добирает временной дизеринг. Умножение на пиксель вместо таблиц
+// [3][256] на каждый канал экономит 1.5 КБ RAM.
+static uint32_t channelScale[3];
+static int16_t lutBrightness = -1;  // Яркость, под которую посчитаны множители
+
+static uint8_t outputBrightness = 255;  // Яркость из setOutputBrightness()
+static uint8_t powerScale = 255;        // Множитель ограничителя тока (255 = без ограничения)
+static uint16_t powerLimitMa = 0;
+static uint16_t powerLeds = 0;
+
+// Пороги дизеринга в порядке bit-reversal: соседние кадры гасят ошибку друг друга
+static const uint8_t DITHER_THRESHOLDS[OUTPUT_DITHER_STEPS] = {16, 144, 80, 208, 48, 176, 112, 240};
+static uint8_t ditherFrame = 0;
+static uint16_t outputCount = MAX_LEDS;  // Диодов, выведенных прошлым кадром, дальше - чёрный хвост
+
+void initOutput() {
+  for (uint16_t v = 0; v < 256; v++) {
+    gammaLut[v] = (uint16_t)(powf(v / 255.0f, LED_GAMMA) * 65535.0f + 0.5f);
+  }
+  lutBrightness = -1;
+}
+
+// Множители пересчитываются только при смене яркости или множителя ограничителя
+static void updateChannelScale() {
+  uint8_t brightness = powerScale == 255 ? outputBrightness : scale8_video(outputBrightness, powerScale);
+  if (brightness == lutBrightness) {
+    return;
+  }
+  lutBrightness = brightness;
+  
+  CRGB correction = LED_COLOR_CORRECTION;
+  for (uint8_t c = 0; c < 3; c++) {
+    // (a+1)(b+1)-1 вместо a*b/255: сдвиг вместо деления, 255×255 даёт ровно 65535
+    uint32_t scale = 0;
+    if (brightness > 0 && correction[c] > 0) {
+      scale = ((uint32_t)brightness + 1) * (correction[c] + 1) - 1;
+    }
+    channelScale[c] = scale;
+  }
+}
+
+void setOutputBrightness(uint8_t brightness) {
+  outputBrightness = brightness;
+}
+
+void setOutputPowerLimit(uint16_t limitMa, uint16_t numLeds) {
+  powerLimitMa = limitMa;
+  powerLeds = numLeds;
+  if (limitMa == 0) {
+    powerScale = 255;
+  }
+}
+
+bool renderOutput(const CRGB* src, uint16_t count, bool dither) {
+  updateChannelScale();
+  if (count < outputCount) {
+    // Лента стала короче: хвост гасится один раз, дальше каскад его не трогает
+    fill_solid(outputLeds + count, outputCount - count, CRGB::Black);
+  }
+  outputCount = count;
+  
+  // Дизеринг нужен только тёмным уровням: выше разница между соседними
+  // уровнями не видна, а неизменный кадр можно не выводить повторно.
+  // Граница кратна 256, поэтому усреднённый уровень не проседает на ней.
+  // Без дизеринга все уровни просто округляются
+  const uint16_t ditherLimit = dither ? LED_DITHER_BELOW << 8 : 0;
+  uint8_t fraction = 0;
+  uint32_t channelSum[3] = {0, 0, 0};  // Для оценки тока, без отдельного прохода
+  
+  const uint8_t* in = (const uint8_t*)src;
+  uint8_t* out = (uint8_t*)outputLeds;
+  
+  for (uint16_t i = 0; i < count; i++) {
+    // Сдвиг по пикселю: соседние диоды мерцают не синхронно
+    uint8_t ditherThreshold = DITHER_THRESHOLDS[(ditherFrame + i) & (OUTPUT_DITHER_STEPS - 1)];
+    for (uint8_t c = 0; c < 3; c++) {
+      uint16_t level = ((uint32_t)gammaLut[*in++] * channelScale[c]) >> 16;
+      uint8_t threshold = 128;  // Обычное округление
+      if (level < ditherLimit) {
+        threshold = ditherThreshold;
+        fraction |= level & 0xFF;
+      }
+      uint32_t value = ((uint32_t)level + threshold) >> 8;
+      if (value > 255) value = 255;
+      *out++ = value;
+      channelSum[c] += value;
+    }
+  }
+  ditherFrame++;
+  
+  // Модель потребления FastLED: мА на канал при 255 плюс ток покоя каждого диода
+  uint32_t idleMa = (uint32_t)powerLeds * LED_IDLE_MA;
+  uint32_t activeMa = (channelSum[0] * LED_RED_MA + channelSum[1] * LED_GREEN_MA +
+                       channelSum[2] * LED_BLUE_MA) / 255;
+  uint8_t prevScale = powerScale;
+  
+  // Без ограничителя кадр запросил бы в 255/powerScale раз больше
+  powerStats.requestedMa = idleMa + activeMa * 255 / (powerScale ? powerScale : 1);
+  powerStats.estimatedMa = idleMa + activeMa;
+  
+  if (powerLimitMa > 0) {
+    uint32_t budgetMa = powerLimitMa > idleMa ? powerLimitMa - idleMa : 0;
+    
+    // Кадр стал ярче, чем рассчитывал множитель: гасим его сразу,
+    // дополнительный проход бывает только на таком скачке
+    if (activeMa > budgetMa) {
+      uint8_t fix = budgetMa * 255 / activeMa;
+      nscale8((CRGB*)outputLeds, count, fix);
+      powerStats.estimatedMa = idleMa + activeMa * fix / 255;
+    }
+    
+    // Множитель для следующего кадра по запрошенному без ограничения току
+    uint32_t requestedActiveMa = powerStats.requestedMa - idleMa;
+    powerScale = requestedActiveMa > budgetMa ? budgetMa * 255 / requestedActiveMa : 255;
+    if (powerScale < 255 || activeMa > budgetMa) {
+      powerStats.throttledFrames++;
+    }
+  }
+  powerStats.scale = powerScale;
+  
+  // Кадр с дизерингом или с новым множителем нужно вывести ещё раз
+  return fraction != 0 || powerScale != prevScale;
+}
+
+uint16_t outputLevel(uint8_t channel, uint8_t value) {
+  return channel < 3 ? ((uint32_t)gammaLut[value] * channelScale[channel]) >> 16 : 0;
+}
@@ -0,0 +1,43 @@
+#ifndef LED_OUTPUT_H
+#define LED_OUTPUT_H
+
+#include <FastLED.h>
+#include "config.h"
+
+// Выходной каскад: гамма, яркость, цветокоррекция и временной дизеринг
+// за один проход leds[] -> outputLeds[]. FastLED выводит outputLeds[],
+// а leds[] остаётся кадром режима (режимы дорисовывают свой прошлый кадр).
+extern CRGB outputLeds[MAX_LEDS];
+
+// Длина цикла дизеринга (кадров): за цикл каждый пиксель проходит все пороги
+#define OUTPUT_DITHER_STEPS 8
+
+// Таблица гаммы. Считается один раз при старте
+void initOutput();
+
+// Яркость вывода (0-255). Множители каналов пересчитываются только при изменении
+void setOutputBrightness(uint8_t brightness);
+
+// Ограничитель тока: лимит в мА (0 = без ограничения) и число подключённых диодов
+void setOutputPowerLimit(uint16_t limitMa, uint16_t numLeds);
+
+// Оценка тока по кадру, считается в том же проходе, что и вывод
+struct PowerStats {
+  uint32_t estimatedMa;      // Ток последнего кадра после ограничения
+  uint32_t requestedMa;      // Ток, который кадр потребовал бы без ограничения
+  uint8_t scale;             // Множитель ограничителя (255 = не ограничивает)
+  uint32_t throttledFrames;  // Кадров, приглушённых ограничителем
+};
+
+extern PowerStats powerStats;
+
+// Проход leds[] -> outputLeds[] с оценкой тока. Возвращает true, если кадр
+// нужно выводить и дальше, даже если leds[] не меняется (дизеринг, ограничитель).
+// dither = false - уровни только округляются, такой кадр можно не повторять.
+// Обрабатываются первые count диодов, хвост outputLeds[] гасится, когда count уменьшается
+bool renderOutput(const CRGB* src, uint16_t count, bool dither = true);
+
+// Уровень канала (0-2) после гаммы, яркости и коррекции, 8.8 с фиксированной точкой
+uint16_t outputLevel(uint8_t channel, uint8_t value);
+
+#endif
@@ -1,9 +1,20 @@
 #include "led_state.h"
+#include "led_modes.h"
 #include "config.h"
+#include "settings_journal.h"
+#include "settings_schema.h"
 #include <EEPROM.h>
 
 LEDState ledState;
 volatile bool settingsChanged = false;
+SaveStats saveStats = {0, 0, 0, 0};
+
+static bool savePending = false;
+static uint32_t firstChangeMs = 0;
+static uint32_t lastChangeMs = 0;
+
+// Закодированное состояние (TLV) или прочитанная структура старой версии
+static uint8_t stateBlob[SCHEMA_ENCODED_SIZE > SCHEMA_LEGACY_SIZE ? SCHEMA_ENCODED_SIZE : SCHEMA_LEGACY_SIZE];
 
 void initLEDState() {
   ledState.power = true;
@@ -15,9 +26,9 @@ void initLEDState() {
   
   // Инициализация настроек режимов по умолчанию
   for (int i = 0; i < TOTAL_MODES; i++) {
-    ledState.modeSettings[i].speed = 128;
-    ledState.modeSettings[i].scale = 128;
-    ledState.modeSettings[i].color1 = CRGB::Red;
+    ledState.modeSettings[i].speed = MODE_REGISTRY[i].defaultSpeed;
+    ledState.modeSettings[i].scale = MODE_REGISTRY[i].defaultScale;
+    ledState.modeSettings[i].color1 = MODE_REGISTRY[i].defaultColor1;
     ledState.modeSettings[i].color2 = CRGB::Blue;
     ledState.modeSettings[i].brightness = 255;
     ledState.modeSettings[i].archived = false;
@@ -30,11 +41,24 @@ void initLEDState() {
     ledState.schedules[i].minute = 0;
     ledState.schedules[i].action = true;
     ledState.schedules[i].daysOfWeek = 0x7F;  // Все дни недели
+    ledState.schedules[i].preset = 0;
+  }
+  
+  ledState.transitionMs = DEFAULT_TRANSITION_MS;
+  ledState.powerLimitMa = DEFAULT_POWER_LIMIT_MA;
+  for (int i = 0; i < TOTAL_MODES; i++) {
+    ledState.paletteSource[i] = PALETTE_BUILTIN;
   }
+  ledState.userPalette.count = 0;
 }
 
-void saveLEDState() {
-  // Сохранение в EEPROM
+// EEPROM.begin(1024) ниже: заголовок и состояние должны поместиться целиком
+static_assert(sizeof(EEPROMHeader) + sizeof(stateBlob) <= 1024, "LEDState does not fit into EEPROM");
+// Снимок журнала занимает один сектор
+static_assert(sizeof(stateBlob) <= JOURNAL_MAX_STATE_SIZE, "LEDState does not fit into a journal sector");
+
+// Запасной путь, если во флеше нет области под журнал (ld-скрипт без файловой системы)
+static void saveLegacyEEPROM(uint16_t length) {
   EEPROM.begin(1024);  // Увеличили размер для расписаний
   
   // Сохраняем заголовок с магическим числом
@@ -43,64 +67,124 @@ void saveLEDState() {
   header.version = EEPROM_VERSION;
   EEPROM.put(0, header);
   
-  // Сохраняем состояние LED после заголовка
-  EEPROM.put(sizeof(EEPROMHeader), ledState);
+  // Сохраняем закодированное состояние после заголовка
+  for (uint16_t i = 0; i < length; i++) {
+    EEPROM.write(sizeof(EEPROMHeader) + i, stateBlob[i]);
+  }
   
   EEPROM.commit();
   EEPROM.end();
 }
 
+void saveLEDState() {
+  uint16_t length = encodeLEDState(stateBlob, sizeof(stateBlob));
+  if (!journalAvailable()) {
+    saveLegacyEEPROM(length);
+    return;
+  }
+  // В журнал дописываются только изменившиеся байты
+  if (!journalSave(stateBlob, length, EEPROM_VERSION)) {
+    Serial.println("❌ Failed to save LED state to settings journal");
+  }
+}
 
-void loadLEDState() {
-  // Загрузка из EEPROM
-  EEPROM.begin(1024);  // Увеличили размер для расписаний
+// Чтение EEPROM старой прошивки (или запасного пути без журнала).
+// Возвращает версию данных, 0 - данных нет
+static uint8_t readLegacyEEPROM() {
+  EEPROM.begin(1024);
   
-  // Читаем заголовок
   EEPROMHeader header;
   EEPROM.get(0, header);
-  
-  // Проверяем магическое число
+  uint8_t version = 0;
   if (header.magic == EEPROM_MAGIC) {
-    if (header.version == EEPROM_VERSION) {
-      // Данные валидны - загружаем состояние
-      EEPROM.get(sizeof(EEPROMHeader), ledState);
-      Serial.println("✅ LED state loaded from EEPROM");
-    } else if (header.version == 1) {
-      // Миграция с версии 1 на версию 2
-      Serial.println("🔄 Migrating EEPROM from v1 to v2...");
-      
-      // Загружаем старые данные (без расписаний)
-      EEPROM.get(sizeof(EEPROMHeader), ledState);
-      
-      // Инициализируем новые поля (расписания)
-      for (int i = 0; i < MAX_SCHEDULES; i++) {
-        ledState.schedules[i].enabled = false;
-        ledState.schedules[i].hour = 0;
-        ledState.schedules[i].minute = 0;
-        ledState.schedules[i].action = true;
-        ledState.schedules[i].daysOfWeek = 0x7F;
-      }
-      
-      EEPROM.end();
-      saveLEDState();  // Сохраняем с новой версией
-      Serial.println("✅ Migration complete");
+    version = header.version;
+    for (uint16_t i = 0; i < sizeof(stateBlob); i++) {
+      stateBlob[i] = EEPROM.read(sizeof(EEPROMHeader) + i);
+    }
+  }
+  
+  EEPROM.end();
+  return version;
+}
+
+void loadLEDState() {
+  // Журнал, если его ещё нет - EEPROM старой прошивки.
+  // Любая версия читается за один проход, миграции - в decodeLEDState().
+  // Журнал сам проверяет собранное состояние через decodeLEDState() и при
+  // ошибке CRC берёт последнее целое, а не сбрасывает настройки
+  uint8_t version;
+  uint16_t length;
+  bool fromJournal = journalLoad(stateBlob, sizeof(stateBlob), version, length, decodeLEDState);
+  const char* source = fromJournal ? "settings journal" : "EEPROM";
+  if (!fromJournal) {
+    version = readLegacyEEPROM();
+    length = sizeof(stateBlob);
+    if (version == 0) {
+      // Первый запуск - инициализируем и сохраняем
+      Serial.println("⚠️ No valid saved settings found, initializing defaults");
+      initLEDState();
+      saveLEDState();
       return;
-    } else {
-      // Неизвестная версия
-      Serial.println("⚠️ Unknown EEPROM version, initializing defaults");
+    }
+    if (!decodeLEDState(stateBlob, length, version)) {
+      Serial.printf("⚠️ Unsupported or damaged %s data (v%d), initializing defaults\n", source, version);
       initLEDState();
-      EEPROM.end();
       saveLEDState();
       return;
     }
+  }
+  
+  if (version != EEPROM_VERSION) {
+    Serial.printf("🔄 Migrated %s from v%d to v%d\n", source, version, EEPROM_VERSION);
   } else {
-    // Первый запуск или неверные данные - инициализируем и сохраняем
-    Serial.println("⚠️ No valid EEPROM data found, initializing defaults");
-    initLEDState();
-    EEPROM.end();
-    saveLEDState();  // Сохраняем с правильным заголовком
+    Serial.printf("✅ LED state loaded from %s\n", source);
+  }
+  // Новая версия или перенос из EEPROM - сразу в журнал
+  if (version != EEPROM_VERSION || !fromJournal) {
+    saveLEDState();
+  }
+}
+
+// Забрать флаг от обработчиков API в очередь отложенной записи
+static void takeSettingsChanged(uint32_t now) {
+  if (!settingsChanged) {
     return;
   }
-  
-  EEPROM.end();
+  settingsChanged = false;
+  if (savePending) {
+    saveStats.coalesced++;
+  } else {
+    savePending = true;
+    firstChangeMs = now;
+  }
+  saveStats.pendingChanges++;
+  lastChangeMs = now;
+}
+
+static void commitSettings() {
+  saveLEDState();
+  savePending = false;
+  saveStats.pendingChanges = 0;
+  saveStats.commits++;
+}
+
+bool serviceSettingsSave() {
+  uint32_t now = millis();
+  takeSettingsChanged(now);
+  if (!savePending) {
+    return false;
+  }
+  if (now - lastChangeMs < SETTINGS_SAVE_IDLE_MS && now - firstChangeMs < SETTINGS_SAVE_MAX_AGE_MS) {
+    return false;
+  }
+  commitSettings();
+  return true;
+}
+
+void flushSettings() {
+  takeSettingsChanged(millis());
+  if (savePending) {
+    saveStats.forcedFlushes++;
+    commitSettings();
+  }
 }
@@ -12,7 +12,7 @@ struct EEPROMHeader {
 };
 
 #define EEPROM_MAGIC 0x4C454456  // "LEDV" in hex
-#define EEPROM_VERSION 3
+#define EEPROM_VERSION 4  // До 3 - структура как есть, с 4 - TLV (settings_schema.h)
 
 // Структура расписания
 struct Schedule {
@@ -21,6 +21,7 @@ struct Schedule {
   uint8_t minute;      // Минута (0-59)
   bool action;         // true = включить, false = выключить
   uint8_t daysOfWeek;  // Битовая маска дней недели (bit 0 = Пн, bit 6 = Вс, 0x7F = все дни)
+  uint8_t preset;      // При включении применить пресет: номер + 1, 0 = без пресета
 };
 
 // Настройки режима
@@ -33,6 +34,27 @@ struct ModeSettings {
   bool archived;          // Архивный режим (не показывать и не переключать)
 };
 
+// Откуда режим берёт палитру (см. palette.h)
+enum PaletteSource : uint8_t {
+  PALETTE_BUILTIN = 0,  // Встроенная радуга (исходный вид режима)
+  PALETTE_COLORS = 1,   // Градиент color1 -> color2 -> color1
+  PALETTE_CUSTOM = 2    // Загруженная палитра userPalette
+};
+
+#define MAX_PALETTE_STOPS 8
+
+// Опорная точка градиента
+struct PaletteStop {
+  uint8_t pos;            // Позиция в палитре (0-255), точки идут по возрастанию
+  CRGB color;
+};
+
+// Палитра, загруженная через /api/mode/settings
+struct UserPalette {
+  uint8_t count;          // Количество точек (0 = не задана)
+  PaletteStop stops[MAX_PALETTE_STOPS];
+};
+
 // Глобальное состояние гирлянды
 struct LEDState {
   bool power;                     // Вкл/выкл
@@ -43,6 +65,10 @@ struct LEDState {
   bool randomOrder;               // Случайный порядок режимов
   ModeSettings modeSettings[TOTAL_MODES];  // Настройки каждого из режимов
   Schedule schedules[10];         // Расписания включения/выключения
+  uint16_t transitionMs;          // Плавный переход между режимами (мс, 0 = мгновенно)
+  uint16_t powerLimitMa;          // Лимит тока ленты (мА, 0 = без ограничения)
+  uint8_t paletteSource[TOTAL_MODES];  // PaletteSource каждого режима
+  UserPalette userPalette;        // Общая загруженная палитра
 };
 
 // Глобальная переменная состояния
@@ -54,4 +80,23 @@ void initLEDState();
 void saveLEDState();
 void loadLEDState();
 
+// Отложенное сохранение: изменения подряд (ползунок яркости шлёт запрос
+// каждые MIN_REQUEST_INTERVAL) объединяются в одну запись во флеш
+struct SaveStats {
+  uint32_t pendingChanges;  // Изменений ждут записи
+  uint32_t coalesced;       // Изменений, объединённых с предыдущими
+  uint32_t commits;         // Записей во флеш
+  uint32_t forcedFlushes;   // Принудительных записей (OTA, перезагрузка)
+};
+
+extern SaveStats saveStats;
+
+// Вызывается из loop(): забирает settingsChanged и сохраняет после паузы
+// SETTINGS_SAVE_IDLE_MS, но не позже SETTINGS_SAVE_MAX_AGE_MS от первого
+// изменения. Возвращает true, если настройки записаны.
+bool serviceSettingsSave();
+
+// Записать отложенные изменения сейчас (перед OTA и перезагрузкой)
+void flushSettings();
+
 #endif
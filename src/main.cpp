@@ -7,34 +7,36 @@
 #include <WiFiClient.h>
 #include "config.h"
 #include "led_state.h"
+#include "preset_store.h"
+#include "rtc_state.h"
+#include "random_pool.h"
 #include "led_modes.h"
 #include "webserver.h"
 #include "logger.h"
 #include "diagnostics.h"
-
-// Названия режимов (должны совпадать с frontend)
-const char* MODE_NAMES[] = {
-  "Смешанные волны",    // Blendwave
-  "Радужная пульсация", // Rainbow Beat
-  "Две синусоиды",      // Two Sin
-  "Конфетти",           // Confetti
-  "Огонь",              // Fire
-  "Радужный марш",      // Rainbow March
-  "Плазма",             // Plasma
-  "Шум",                // Noise
-  "Жонглирование",      // Juggle
-  "Один цвет",          // Solid Color
-  "Снегопад",           // Snowfall
-  "Северное сияние",    // Aurora
-  "Светлячки"           // Fireflies
-};
+#include "mode_bench.h"
 
 // Авто-переключение режимов
 unsigned long lastModeSwitch = 0;
 
-// Отслеживание последней проверки расписания
+// Отслеживание последней проверки расписания (переживает тёплый старт, rtc_state.h)
 int lastCheckedMinute = -1;
 
+// Пауза в setup(). После тёплого старта лента не замирает на время
+// подключения к WiFi: вместо delay() рисуются кадры восстановленного режима
+static void setupWait(uint32_t ms) {
+  if (!rtcStateStats.warmBoot) {
+    delay(ms);
+    return;
+  }
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    runMode(ledState.currentMode);
+    showFrame();
+    delay(getModeDescriptor(ledState.currentMode).frameMs);
+  }
+}
+
 // Функция синхронизации времени через HTTP API
 bool syncTimeViaHTTP() {
   WiFiClient client;
@@ -88,9 +90,14 @@ void setup() {
   LOG_PRINTLN("BOOT: System Restarted");
   LOG_PRINTF("Reset Reason: %s\n", ESP.getResetReason().c_str());
   
-  // Инициализация LED state
+  // Инициализация LED state. После программного сброса (WDT, OTA,
+  // ESP.restart()) состояние берётся из RTC памяти, флеш не читается:
+  // журнал ищется при первом сохранении, пресеты - при первом обращении
   initLEDState();
-  loadLEDState();
+  if (!restoreRtcState()) {
+    loadLEDState();
+    seedRandomPool(random(0x7FFFFFFF));
+  }
   
   // Инициализация LED ленты ПЕРЕД подключением к WiFi для анимации
   initLEDs();
@@ -114,16 +121,19 @@ void setup() {
   
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
   
-  // Анимация подключения на LED
+  // Анимация подключения на LED. После тёплого старта вместо неё
+  // продолжается режим, который шёл до сброса
   int dotCount = 0;
   while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
+    setupWait(500);
     LOG_PRINT(".");
     
     // Бегущий огонёк во время подключения
-    FastLED.clear();
-    leds[dotCount % ledState.numLeds] = CRGB::Blue;
-    FastLED.show();
+    if (!rtcStateStats.warmBoot) {
+      fill_solid(leds, MAX_LEDS, CRGB::Black);
+      leds[dotCount % ledState.numLeds] = CRGB::Blue;
+      showLeds();
+    }
     dotCount++;
     
     // Таймаут 30 секунд
@@ -133,9 +143,11 @@ void setup() {
       
       // Красная вспышка - ошибка
       fill_solid(leds, ledState.numLeds, CRGB::Red);
-      FastLED.show();
+      showLeds();
       delay(2000);
       
+      flushSettings();
+      saveRtcState();
       ESP.restart();
     }
   }
@@ -144,12 +156,14 @@ void setup() {
   LOG_PRINT("IP address: ");
   LOG_PRINTLN(WiFi.localIP().toString());
   
-  // Зелёная вспышка - успех
-  fill_solid(leds, ledState.numLeds, CRGB::Green);
-  FastLED.show();
-  delay(1000);
-  FastLED.clear();
-  FastLED.show();
+  // Зелёная вспышка - успех (после тёплого старта режим не прерываем)
+  if (!rtcStateStats.warmBoot) {
+    fill_solid(leds, ledState.numLeds, CRGB::Green);
+    showLeds();
+    delay(1000);
+    fill_solid(leds, MAX_LEDS, CRGB::Black);
+    showLeds();
+  }
   
   // Инициализация NTP через встроенные функции ESP8266
   LOG_PRINTLN("🕐 Initializing NTP...");
@@ -167,7 +181,7 @@ void setup() {
   time_t now = time(nullptr);
   
   while (now < 1000000000 && ntpRetries < 10) {  // Уменьшили попытки NTP
-    delay(500);
+    setupWait(500);
     LOG_PRINT(".");
     now = time(nullptr);
     ntpRetries++;
@@ -203,8 +217,13 @@ void setup() {
       type = "sketch";
     } else { // U_FS
       type = "filesystem";
+      // Журнал настроек и пресеты живут в этом разделе (settings_journal.h)
+      LOG_PRINTLN("⚠️ Filesystem image overwrites saved settings and presets");
     }
     LOG_PRINTLN("Start updating " + type);
+    // Несохранённые настройки пишем до прошивки: после неё плата перезагрузится
+    flushSettings();
+    saveRtcState();
     // Выключаем LED во время обновления
     FastLED.clear();
     FastLED.show();
@@ -287,9 +306,19 @@ void checkSchedules() {
       continue;  // Этот день недели не активен
     }
     
-    // Выполняем действие
+    // Выполняем действие (при включении - вместе с пресетом). Пресет по
+    // расписанию действует только до перезагрузки: журнал настроек не пишется
+    bool presetApplied = false;
+    if (schedule.action && schedule.preset) {
+      presetApplied = applyPreset(schedule.preset - 1);
+      if (!presetApplied) {
+        LOG_PRINTF("⚠️ Schedule %d: preset %d not found\n", i, schedule.preset - 1);
+      }
+    }
     ledState.power = schedule.action;
-    settingsChanged = true;
+    if (!presetApplied) {
+      settingsChanged = true;
+    }
     
     LOG_PRINT("⏰ Schedule triggered: ");
     LOG_PRINT(schedule.action ? "ON" : "OFF");
@@ -330,11 +359,23 @@ void loop() {
     diag.taskEnd();
   }
   
-  // Set brightness once per frame to avoid flickering
-  FastLED.setBrightness(ledState.brightness);
+  // Бенчмарк режимов (/api/bench) временно забирает ленту.
+  // Автопереключение и сохранение ждут его окончания, чтобы не сбить замеры
+  if (isModeBenchActive()) {
+    diag.taskStart("Bench");
+    modeBenchStep();
+    diag.taskEnd();
+    diag.loopEnd();
+    return;
+  }
   
-  // Запуск текущего режима LED
-  EVERY_N_MILLISECONDS(20) {
+  // Запуск текущего режима LED. Интервал кадра подстраивает diag по стоимости
+  // отрисовки: от интервала из реестра режимов до FRAME_MAX_INTERVAL_MS
+  static unsigned long lastFrameTime = 0;
+  unsigned long frameNow = millis();
+  if (frameNow - lastFrameTime >= diag.frameInterval(ledState.currentMode)) {
+    diag.frameStart(ledState.currentMode, frameNow - lastFrameTime);
+    lastFrameTime = frameNow;
     diag.taskStart("LEDs");
     
     // Check if time is synchronized (year > 2001)
@@ -346,9 +387,10 @@ void loop() {
       fill_solid(leds, ledState.numLeds, CRGB::Green);
     }
     
-    // Show the frame
-    FastLED.show();
+    // Show the frame (пропускается, если кадр не изменился)
+    showFrame();
     diag.taskEnd();
+    diag.frameEnd();
   }
   
   // Авто-переключение режимов
@@ -405,7 +447,7 @@ void loop() {
         // Используем sprintf вместо String для избежания фрагментации кучи
         char logMsg[100];
         snprintf(logMsg, sizeof(logMsg), "Auto-switched to mode: %s (%d)", 
-                 MODE_NAMES[ledState.currentMode], 
+                 MODE_REGISTRY[ledState.currentMode].name, 
                  ledState.currentMode);
         LOG_PRINTLN(logMsg);
         
@@ -413,19 +455,25 @@ void loop() {
         // Частые записи в EEPROM вызывают watchdog reset и крэши.
         // Режим сохраняется только при ручном выборе через веб-интерфейс.
         // saveLEDState();  // ← REMOVED to prevent crashes
+        // Но в RTC память - сразу: после сброса продолжим с этого режима
+        saveRtcState();
       }
     }
   }
   
 
   
-  // Сохранение настроек в главном цикле (безопасно для EEPROM)
-  if (settingsChanged) {
-    LOG_PRINTLN("💾 Settings changed, saving to EEPROM...");
-    saveLEDState();
-    settingsChanged = false;
-    LOG_PRINTLN("✅ Settings saved");
+  // Сохранение и удаление пресетов по запросам API
+  servicePresets();
+  
+  // Сохранение настроек в главном цикле: изменения копятся до паузы
+  // SETTINGS_SAVE_IDLE_MS и пишутся в журнал настроек одной записью
+  if (serviceSettingsSave()) {
+    LOG_PRINTLN("💾 Settings saved");
   }
+  
+  // Горячее состояние в RTC память для тёплого перезапуска
+  serviceRtcState();
 
   diag.loopEnd();
 }
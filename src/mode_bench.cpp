@@ -0,0 +1,181 @@
+#include "mode_bench.h"
+#include "led_state.h"
+#include "led_modes.h"
+#include "led_output.h"
+#include "logger.h"
+#include <algorithm>
+
+struct BenchStats {
+  uint32_t minCycles;
+  uint32_t avgCycles;
+  uint32_t p99Cycles;
+};
+
+struct ModeBenchResult {
+  BenchStats render;
+  BenchStats show;
+};
+
+enum BenchPhase : uint8_t { BENCH_IDLE, BENCH_RUNNING, BENCH_DONE };
+
+// Запрос от HTTP обработчика; забирается в loop()
+static volatile uint16_t requestedFrames = 0;
+
+static BenchPhase phase = BENCH_IDLE;
+static uint16_t benchFrames = 0;
+static uint8_t benchMode = 0;
+static uint16_t benchFrame = 0;
+static uint32_t* renderSamples = nullptr;
+static uint32_t* showSamples = nullptr;
+static ModeBenchResult results[TOTAL_MODES];
+
+// Живое состояние, которое бенчмарк подменяет на время прогона
+static uint8_t savedMode = 0;
+static bool savedPower = true;
+static uint16_t savedTransitionMs = 0;
+
+bool requestModeBench(uint16_t frames) {
+  if (phase == BENCH_RUNNING || requestedFrames != 0) {
+    return false;
+  }
+  if (frames == 0) frames = BENCH_DEFAULT_FRAMES;
+  if (frames > BENCH_MAX_FRAMES) frames = BENCH_MAX_FRAMES;
+  requestedFrames = frames;
+  return true;
+}
+
+bool isModeBenchActive() {
+  return phase == BENCH_RUNNING || requestedFrames != 0;
+}
+
+static BenchStats summarize(uint32_t* samples, uint16_t count) {
+  std::sort(samples, samples + count);
+
+  uint64_t total = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    total += samples[i];
+  }
+
+  BenchStats stats;
+  stats.minCycles = samples[0];
+  stats.avgCycles = total / count;
+  stats.p99Cycles = samples[std::min<uint16_t>((uint32_t)count * 99 / 100, count - 1)];
+  return stats;
+}
+
+static void finishBench() {
+  free(renderSamples);
+  free(showSamples);
+  renderSamples = nullptr;
+  showSamples = nullptr;
+
+  // Без перехода из последнего замеренного режима, и авто-переключение
+  // отсчитывает свою задержку заново, а не переключает сразу
+  setModeImmediately(savedMode);
+  ledState.power = savedPower;
+  ledState.transitionMs = savedTransitionMs;
+  lastModeSwitch = millis();
+  phase = BENCH_DONE;
+
+  LOG_PRINTLN("⏱️ Mode benchmark finished");
+}
+
+static void beginBench() {
+  benchFrames = requestedFrames;
+
+  renderSamples = (uint32_t*)malloc(benchFrames * sizeof(uint32_t));
+  showSamples = (uint32_t*)malloc(benchFrames * sizeof(uint32_t));
+  if (renderSamples == nullptr || showSamples == nullptr) {
+    LOG_PRINTLN("❌ Mode benchmark: not enough heap");
+    free(renderSamples);
+    free(showSamples);
+    renderSamples = nullptr;
+    showSamples = nullptr;
+    requestedFrames = 0;
+    return;
+  }
+
+  savedMode = ledState.currentMode;
+  savedPower = ledState.power;
+  savedTransitionMs = ledState.transitionMs;
+  ledState.power = true;  // Иначе runMode() только гасит ленту
+  ledState.transitionMs = 0;  // Замеряем сами режимы, без переходов между ними
+
+  benchMode = 0;
+  benchFrame = 0;
+  phase = BENCH_RUNNING;
+  requestedFrames = 0;
+
+  LOG_PRINTF("⏱️ Mode benchmark started: %u frames per mode, Heap: %u\n", benchFrames, ESP.getFreeHeap());
+}
+
+void modeBenchStep() {
+  if (phase != BENCH_RUNNING) {
+    if (requestedFrames == 0) return;
+    beginBench();
+    if (phase != BENCH_RUNNING) return;
+  }
+
+  ledState.currentMode = benchMode;
+  setOutputBrightness(ledState.brightness);
+
+  uint32_t start = ESP.getCycleCount();
+  runMode(benchMode);
+  uint32_t rendered = ESP.getCycleCount();
+  showLeds();  // Выходной каскад + FastLED.show()
+  uint32_t shown = ESP.getCycleCount();
+
+  // Первые кадры режима не считаем: в них инициализируется его состояние
+  if (benchFrame >= BENCH_WARMUP_FRAMES) {
+    uint16_t sample = benchFrame - BENCH_WARMUP_FRAMES;
+    renderSamples[sample] = rendered - start;
+    showSamples[sample] = shown - rendered;
+  }
+  benchFrame++;
+
+  if (benchFrame < benchFrames + BENCH_WARMUP_FRAMES) {
+    return;
+  }
+
+  results[benchMode].render = summarize(renderSamples, benchFrames);
+  results[benchMode].show = summarize(showSamples, benchFrames);
+
+  benchFrame = 0;
+  benchMode++;
+  if (benchMode >= TOTAL_MODES) {
+    finishBench();
+  }
+}
+
+void fillModeBenchJson(JsonDocument& doc) {
+  if (phase == BENCH_RUNNING || requestedFrames != 0) {
+    doc["state"] = "running";
+    doc["progress"] = benchMode;
+    doc["total"] = TOTAL_MODES;
+    return;
+  }
+
+  doc["state"] = phase == BENCH_DONE ? "done" : "idle";
+  if (phase != BENCH_DONE) return;
+
+  doc["frames"] = benchFrames;
+  doc["cpuMHz"] = ESP.getCpuFreqMHz();
+  doc["numLeds"] = ledState.numLeds;
+
+  JsonArray modes = doc.createNestedArray("modes");
+  for (int i = 0; i < TOTAL_MODES; i++) {
+    JsonObject mode = modes.createNestedObject();
+    mode["id"] = i;
+    mode["name"] = MODE_REGISTRY[i].name;
+
+    JsonObject render = mode.createNestedObject("render");
+    render["min"] = results[i].render.minCycles;
+    render["avg"] = results[i].render.avgCycles;
+    render["p99"] = results[i].render.p99Cycles;
+
+    JsonObject show = mode.createNestedObject("show");
+    show["min"] = results[i].show.minCycles;
+    show["avg"] = results[i].show.avgCycles;
+    show["p99"] = results[i].show.p99Cycles;
+  }
+}
@@ -0,0 +1,31 @@
+#ifndef MODE_BENCH_H
+#define MODE_BENCH_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Бенчмарк режимов на устройстве (/api/bench).
+// HTTP обработчик только ставит запрос; замеры идут из loop() по одному кадру
+// за проход, поэтому между кадрами стек TCP обслуживается как обычно.
+// Время рендера (runMode) и вывода (showLeds: выходной каскад + FastLED.show) считается в тактах ESP.getCycleCount().
+
+#define BENCH_DEFAULT_FRAMES 100
+#define BENCH_MAX_FRAMES 250
+#define BENCH_WARMUP_FRAMES 5
+
+// Запросить прогон (можно вызывать из async обработчика). false - уже идёт
+bool requestModeBench(uint16_t frames);
+
+// Время последнего авто-переключения режима (main.cpp)
+extern unsigned long lastModeSwitch;
+
+// true, пока бенчмарк владеет отрисовкой
+bool isModeBenchActive();
+
+// Один кадр бенчмарка; вызывается из loop() вместо обычной отрисовки
+void modeBenchStep();
+
+// Состояние и результаты для GET /api/bench
+void fillModeBenchJson(JsonDocument& doc);
+
+#endif
@@ -0,0 +1,80 @@
+#include "noise_row.h"
+#include <string.h>
+
+void NoiseRow::fillNodes(uint8_t* nodes, uint16_t from, uint16_t y) {
+  // Координата узла переполняет uint16 так же, как x в inoise8(): шум периодичен
+  for (uint16_t i = from; i < nodeCount; i++) {
+    uint16_t x = gridOrigin + (firstNode + i) * gridUnits;
+    nodes[i] = hasTime ? inoise8(x, y) : inoise8(x);
+  }
+  samples += nodeCount - from;
+}
+
+void NoiseRow::update(uint32_t x0, uint16_t dx, uint16_t y, uint16_t count, bool timed) {
+  if (count == 0) {
+    count = 1;
+  }
+  if (dx == 0) {
+    dx = 1;  // Все пиксели в одной точке: узел на каждую единицу x, шум тот же
+  }
+  
+  // Несколько пикселей на узел, пока узлы не реже NOISE_NODE_UNITS
+  uint8_t shift = 0;
+  while (shift < NOISE_MAX_SPACING_SHIFT && ((uint32_t)dx << (shift + 1)) <= NOISE_NODE_UNITS) {
+    shift++;
+  }
+  uint32_t grid = (uint32_t)dx << shift;
+  // Пиксели реже NOISE_NODE_UNITS: интерполяция между ними исказит шум,
+  // поэтому узлы ставим ровно в пиксели (сетка от x0, значения точные)
+  uint32_t origin = dx > NOISE_NODE_UNITS ? x0 % grid : 0;
+  uint32_t first = (x0 - origin) / grid;
+  uint32_t offset = x0 - origin - first * grid;
+  uint16_t nodes = (offset + (uint32_t)(count - 1) * dx) / grid + 2;
+  uint16_t base = timed ? (y & ~(NOISE_TIME_STEP - 1)) : 0;
+  
+  // Строка сдвинулась по x: узлы, оставшиеся в ней, не пересчитываем
+  uint16_t keptA = 0;
+  if (valid && grid == gridUnits && origin == gridOrigin && timed == hasTime &&
+      first >= firstNode && first - firstNode < nodeCount) {
+    uint16_t skip = first - firstNode;
+    keptA = nodeCount - skip;
+    if (keptA > nodes) {
+      keptA = nodes;
+    }
+    memmove(nodesA, nodesA + skip, keptA);
+    if (timed) {
+      memmove(nodesB, nodesB + skip, keptA);
+    }
+  }
+  uint16_t keptB = keptA;
+  
+  // y перешёл в следующий интервал: опорная строка B становится A
+  if (timed && base != timeBase) {
+    if (base == (uint16_t)(timeBase + NOISE_TIME_STEP)) {
+      memcpy(nodesA, nodesB, keptA);
+    } else {
+      keptA = 0;
+    }
+    keptB = 0;
+  }
+  
+  valid = true;
+  hasTime = timed;
+  gridUnits = grid;
+  gridOrigin = origin;
+  firstNode = first;
+  nodeCount = nodes;
+  timeBase = base;
+  timeFrac = (uint8_t)((y - base) * (256 / NOISE_TIME_STEP));
+  
+  samples = 0;
+  fillNodes(nodesA, keptA, base);
+  if (timed) {
+    fillNodes(nodesB, keptB, base + NOISE_TIME_STEP);
+  }
+  
+  walkNode = 0;
+  walkPos = (uint32_t)(((uint64_t)offset << 16) / grid);
+  walkStep = 0x10000 >> shift;
+  loadNodes();
+}
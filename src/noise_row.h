@@ -0,0 +1,86 @@
+#ifndef NOISE_ROW_H
+#define NOISE_ROW_H
+
+#include <FastLED.h>
+#include "config.h"
+
+// Строка шума Перлина вдоль ленты. Вместо inoise8() на каждый пиксель шум
+// считается в узлах сетки (не реже NOISE_NODE_UNITS по x) и линейно
+// интерполируется между ними. Узлы живут между кадрами: при сдвиге строки
+// по x пересчитываются только новые, а по времени (y) шум интерполируется
+// между двумя опорными строками через NOISE_TIME_STEP. Если пиксели
+// реже NOISE_NODE_UNITS, узлы совпадают с пикселями и шум точный.
+// Экземпляр хранится в состоянии режима (modeState), по одному на строку.
+
+// Максимальное расстояние между узлами (единиц x). Ячейка решётки inoise8 - 256
+#define NOISE_NODE_UNITS 64
+// Не больше 2^3 = 8 пикселей на узел
+#define NOISE_MAX_SPACING_SHIFT 3
+// Шаг опорных строк по времени (степень двойки)
+#define NOISE_TIME_STEP 32
+// Узлов на строку: при одном узле на пиксель - MAX_LEDS плюс два крайних
+#define NOISE_MAX_NODES (MAX_LEDS + 2)
+
+class NoiseRow {
+public:
+  // Строка inoise8(x0 + i * dx, y) для i = 0..count-1
+  void update(uint32_t x0, uint16_t dx, uint16_t y, uint16_t count) {
+    update(x0, dx, y, count, true);
+  }
+  
+  // Строка одномерного шума inoise8(x0 + i * dx)
+  void update(uint32_t x0, uint16_t dx, uint16_t count) {
+    update(x0, dx, 0, count, false);
+  }
+  
+  // Шум для очередного пикселя: после update() - для нулевого, дальше по порядку
+  uint8_t next() {
+    uint8_t value = lerp8by8(left, right, walkPos >> 8);
+    walkPos += walkStep;
+    while (walkPos >= 0x10000) {
+      walkPos -= 0x10000;
+      walkNode++;
+      loadNodes();
+    }
+    return value;
+  }
+  
+  // inoise8() в последнем update(), для статистики
+  uint16_t samples = 0;
+  
+private:
+  void update(uint32_t x0, uint16_t dx, uint16_t y, uint16_t count, bool timed);
+  void fillNodes(uint8_t* nodes, uint16_t from, uint16_t y);
+  
+  uint8_t nodeValue(uint16_t node) const {
+    return hasTime ? lerp8by8(nodesA[node], nodesB[node], timeFrac) : nodesA[node];
+  }
+  
+  void loadNodes() {
+    if (walkNode + 1 < nodeCount) {
+      left = nodeValue(walkNode);
+      right = nodeValue(walkNode + 1);
+    }
+  }
+  
+  bool valid = false;
+  bool hasTime = false;
+  uint32_t gridUnits = 0;   // Расстояние между узлами (единиц x)
+  uint32_t gridOrigin = 0;  // x нулевого узла сетки
+  uint32_t firstNode = 0;   // Номер первого узла на сетке
+  uint16_t nodeCount = 0;
+  uint16_t timeBase = 0;    // y опорной строки A (B = timeBase + NOISE_TIME_STEP)
+  uint8_t timeFrac = 0;     // Положение y между A и B (0-255)
+  
+  // Обход строки в next()
+  uint16_t walkNode = 0;
+  uint32_t walkPos = 0;     // Положение между узлами, 16.16
+  uint32_t walkStep = 0;
+  uint8_t left = 0;
+  uint8_t right = 0;
+  
+  uint8_t nodesA[NOISE_MAX_NODES];
+  uint8_t nodesB[NOISE_MAX_NODES];
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "palette.h"
+#include <string.h>
+
+// Во время перехода рисуются два режима, поэтому держим две таблицы
+#define PALETTE_SLOTS 2
+
+struct PaletteSlot {
+  uint8_t mode;          // Режим, для которого собрана таблица (0xFF = пусто)
+  uint16_t generation;   // Поколение настроек на момент сборки
+  CRGB lut[256];
+};
+
+static PaletteSlot slots[PALETTE_SLOTS] = {};
+static CRGB rainbowLut[256];  // Радуга - палитра по умолчанию
+static bool rainbowReady = false;
+static uint8_t lastSlot = 0;
+static uint16_t paletteGeneration = 1;  // 0 в пустых слотах не совпадёт никогда
+
+void invalidatePalettes() {
+  paletteGeneration++;
+  if (paletteGeneration == 0) {
+    paletteGeneration = 1;
+  }
+}
+
+// hsv2rgb_rainbow(hue, 255, 255) для всех тонов, собирается один раз
+static const CRGB* rainbowTable() {
+  if (!rainbowReady) {
+    for (uint16_t hue = 0; hue < 256; hue++) {
+      hsv2rgb_rainbow(CHSV(hue, 255, 255), rainbowLut[hue]);
+    }
+    rainbowReady = true;
+  }
+  return rainbowLut;
+}
+
+static void buildGradient(CRGB* lut, const PaletteStop* stops, uint8_t count) {
+  // До первой и после последней точки - их цвета
+  fill_solid(lut, stops[0].pos + 1, stops[0].color);
+  for (uint8_t i = 1; i < count; i++) {
+    fill_gradient_RGB(lut, stops[i - 1].pos, stops[i - 1].color, stops[i].pos, stops[i].color);
+  }
+  uint8_t last = stops[count - 1].pos;
+  fill_solid(lut + last, 256 - last, stops[count - 1].color);
+}
+
+static void buildPalette(CRGB* lut, uint8_t mode) {
+  const ModeSettings& settings = ledState.modeSettings[mode];
+  
+  switch (ledState.paletteSource[mode]) {
+    case PALETTE_COLORS: {
+      // Замкнутый градиент: индекс переполняется без скачка цвета
+      PaletteStop stops[3] = {{0, settings.color1}, {128, settings.color2}, {255, settings.color1}};
+      buildGradient(lut, stops, 3);
+      break;
+    }
+    case PALETTE_CUSTOM:
+      if (ledState.userPalette.count >= 2) {
+        buildGradient(lut, ledState.userPalette.stops, ledState.userPalette.count);
+        break;
+      }
+      // Палитра не загружена - показываем радугу
+      // fall through
+    default:
+      memcpy(lut, rainbowTable(), sizeof(rainbowLut));
+      break;
+  }
+}
+
+const CRGB* modePalette(uint8_t mode) {
+  if (mode >= TOTAL_MODES) {
+    mode = 0;
+  }
+  
+  for (uint8_t i = 0; i < PALETTE_SLOTS; i++) {
+    if (slots[i].mode == mode && slots[i].generation == paletteGeneration) {
+      lastSlot = i;
+      return slots[i].lut;
+    }
+  }
+  
+  // Пересобираем слот, которым пользовались не последним
+  uint8_t slot = (lastSlot + 1) % PALETTE_SLOTS;
+  buildPalette(slots[slot].lut, mode);
+  slots[slot].mode = mode;
+  slots[slot].generation = paletteGeneration;
+  lastSlot = slot;
+  return slots[slot].lut;
+}
+
+static_assert(sizeof(CHSV) == sizeof(CRGB), "hsv2rgbStrip converts CHSV to CRGB in place");
+
+void hsv2rgbStrip(CRGB* out, const CHSV* in, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    CHSV hsv = in[i];  // Копия: out[i] может занимать те же байты
+    if (hsv.v == 0) {
+      out[i] = CRGB::Black;
+    } else {
+      hsv2rgb_rainbow(hsv, out[i]);
+    }
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <FastLED.h>
+#include "led_state.h"
+
+// Палитры режимов. Источник палитры (встроенная радуга, color1/color2 или
+// загруженные точки) разворачивается в таблицу из 256 цветов только после
+// изменения настроек, а режимы берут цвет одним чтением из таблицы.
+
+// Таблица палитры режима (256 цветов)
+const CRGB* modePalette(uint8_t mode);
+
+// Сбросить таблицы после изменения цветов, источника палитры или userPalette
+void invalidatePalettes();
+
+// Цвет из палитры с той же кривой яркости, что у CHSV(hue, 255, bright)
+inline CRGB paletteColor(const CRGB* palette, uint8_t index, uint8_t bright) {
+  CRGB color = palette[index];
+  if (bright != 255) {
+    color.nscale8(scale8_video(bright, bright));
+  }
+  return color;
+}
+
+// Пакетное HSV -> RGB для всей ленты, результат как у hsv2rgb_rainbow.
+// Режим заполняет in[] тоном/насыщенностью/яркостью, затем один проход
+// переводит их в out; погашенные пиксели (v == 0) не считаются. CHSV и CRGB
+// одного размера, поэтому in может лежать в том же буфере, что out (режим
+// пишет CHSV прямо в leds[] и не держит отдельных массивов на MAX_LEDS).
+void hsv2rgbStrip(CRGB* out, const CHSV* in, uint16_t count);
+
+#endif
@@ -0,0 +1,127 @@
+#include "particles.h"
+
+uint8_t ParticlePool::spawn(uint16_t position, uint8_t particleHue, uint8_t particleSat,
+                            uint8_t particlePeak, uint8_t particleRate) {
+  uint8_t slot = cursor;
+  for (uint8_t n = 0; n < PARTICLE_CAPACITY; n++) {
+    uint8_t i = (cursor + n) % PARTICLE_CAPACITY;
+    if (phase[i] == 0) {
+      slot = i;
+      break;
+    }
+  }
+  if (phase[slot] == 0) {
+    active++;
+  }
+  cursor = (slot + 1) % PARTICLE_CAPACITY;
+  
+  pos[slot] = position;
+  hue[slot] = particleHue;
+  sat[slot] = particleSat;
+  peak[slot] = particlePeak;
+  rate[slot] = particleRate;
+  if (envelope == PARTICLE_DECAY) {
+    phase[slot] = 255;
+    prevPhase[slot] = 255;
+  } else {
+    phase[slot] = 1;
+    prevPhase[slot] = 0;
+  }
+  return slot;
+}
+
+void ParticlePool::update() {
+  for (uint8_t i = 0; i < PARTICLE_CAPACITY; i++) {
+    uint8_t p = phase[i];
+    prevPhase[i] = p;
+    if (p == 0) {
+      continue;
+    }
+    
+    if (envelope == PARTICLE_DECAY) {
+      p = scale8(p, 255 - rate[i]);
+      if (p < PARTICLE_MIN_LEVEL) {
+        p = 0;
+      }
+    } else {
+      if (p <= 127) {
+        // Разгорание
+        p += rate[i];
+        if (p > 127) p = 128;  // Переход к угасанию
+      } else if (p < 255) {
+        // Угасание
+        p += rate[i];
+        if (p < 128) p = 255;  // Переполнение
+      }
+      // Полностью угасла
+      if (p >= 254) {
+        p = 0;
+      }
+    }
+    
+    phase[i] = p;
+    if (p == 0) {
+      active--;
+    }
+  }
+}
+
+uint8_t ParticlePool::level(uint8_t i, uint8_t alpha) const {
+  uint8_t p = phase[i];
+  uint8_t prev = prevPhase[i];
+  
+  if (envelope == PARTICLE_DECAY) {
+    // Уровень только убывает, а погасшая частица досвечивает до шага
+    return lerp8by8(prev, p, alpha);
+  }
+  
+  // Только что появилась или погасла - интерполировать не с чем
+  if (prev != 0 && p != 0 && p >= prev) {
+    p = lerp8by8(prev, p, alpha);
+  }
+  if (p == 0) {
+    return 0;
+  }
+  // 0->127 соответствует 0->255 яркости, 128->255 - обратно к 0
+  uint8_t eased = p <= 127 ? ease8InOutCubic(p * 2) : ease8InOutCubic((255 - p) * 2);
+  return (eased * peak[i]) / 255;
+}
+
+void ParticlePool::draw(CRGB* leds, uint16_t numLeds, uint8_t alpha, ParticleBlend blend, bool glow) const {
+  for (uint8_t i = 0; i < PARTICLE_CAPACITY; i++) {
+    if ((phase[i] == 0 && prevPhase[i] == 0) || pos[i] >= numLeds) {
+      continue;
+    }
+    uint8_t bright = level(i, alpha);
+    if (bright == 0) {
+      continue;
+    }
+    
+    CRGB color;
+    if (envelope == PARTICLE_DECAY) {
+      // Тускнеет как fadeToBlackBy: линейно по каналам, а не по кривой CHSV
+      color = CHSV(hue[i], sat[i], peak[i]);
+      color.nscale8(bright);
+    } else {
+      color = CHSV(hue[i], sat[i], bright);
+    }
+    
+    uint16_t p = pos[i];
+    if (blend == PARTICLE_BLEND_MAX) {
+      leds[p] |= color;
+    } else {
+      leds[p] += color;
+    }
+    
+    // Ореол на соседних пикселях, чуть белее самой частицы
+    if (glow && bright > 50) {
+      CRGB halo = CHSV(hue[i], sat[i] > 50 ? sat[i] - 30 : 0, bright / 3);
+      if (p > 0) {
+        leds[p - 1] += halo;
+      }
+      if (p < numLeds - 1) {
+        leds[p + 1] += halo;
+      }
+    }
+  }
+}
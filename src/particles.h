@@ -0,0 +1,56 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <FastLED.h>
+#include "config.h"
+
+// Частицы режимов (конфетти, светлячки). Пул фиксированного размера живёт
+// в состоянии режима (modeState), без кучи. Поля лежат отдельными массивами
+// (structure of arrays): update() проходит только по фазам, не трогая цвета.
+// Порядок: spawn() и update() на шаге симуляции, draw() в каждом кадре.
+
+// Размер пула: стоимость update() за шаг ограничена этим числом
+#define PARTICLE_CAPACITY 128
+// Частица с затуханием гаснет, когда уровень опускается ниже этого
+#define PARTICLE_MIN_LEVEL 4
+
+enum ParticleEnvelope : uint8_t {
+  PARTICLE_PULSE,   // Разгорается и гаснет: фаза 1-127 рост, 128-255 спад (светлячки)
+  PARTICLE_DECAY,   // Вспыхивает сразу и тускнеет на rate/256 за шаг (конфетти)
+};
+
+enum ParticleBlend : uint8_t {
+  PARTICLE_BLEND_ADD,   // Сложение с насыщением
+  PARTICLE_BLEND_MAX,   // Максимум по каналам: наложения не дают белых вспышек
+};
+
+struct ParticlePool {
+  ParticleEnvelope envelope = PARTICLE_PULSE;
+  uint8_t active = 0;   // Живых частиц
+  uint8_t cursor = 0;   // С этого слота spawn() ищет свободный
+  
+  uint16_t pos[PARTICLE_CAPACITY] = {};
+  uint8_t phase[PARTICLE_CAPACITY] = {};      // PULSE: фаза, DECAY: уровень; 0 = слот свободен
+  uint8_t prevPhase[PARTICLE_CAPACITY] = {};  // phase до последнего update()
+  uint8_t rate[PARTICLE_CAPACITY] = {};       // Шаг фазы (PULSE) или затухание (DECAY) за update()
+  uint8_t hue[PARTICLE_CAPACITY] = {};
+  uint8_t sat[PARTICLE_CAPACITY] = {};
+  uint8_t peak[PARTICLE_CAPACITY] = {};       // Максимальная яркость
+  
+  explicit ParticlePool(ParticleEnvelope envelope) : envelope(envelope) {}
+  
+  // Новая частица, возвращает её слот. Если пул полон, вытесняется
+  // частица под курсором - самая давняя из появившихся.
+  uint8_t spawn(uint16_t position, uint8_t hue, uint8_t sat, uint8_t peak, uint8_t rate);
+  
+  // Шаг симуляции: фазы всех частиц, погасшие освобождают слот
+  void update();
+  
+  // Яркость частицы в кадре между двумя последними update() (alpha 0-255)
+  uint8_t level(uint8_t i, uint8_t alpha) const;
+  
+  // Отрисовка в leds[0..numLeds). glow добавляет ореол на соседние LED
+  void draw(CRGB* leds, uint16_t numLeds, uint8_t alpha, ParticleBlend blend, bool glow) const;
+};
+
+#endif
@@ -0,0 +1,380 @@
+#include "preset_store.h"
+#include "settings_journal.h"
+#include "palette.h"
+#include "logger.h"
+
+#define PRESET_MAGIC 0x5044454C  // "LEDP"
+#define PRESET_SLOT_SIZE 64
+#define PRESET_SLOTS_PER_SECTOR (JOURNAL_SECTOR_SIZE / PRESET_SLOT_SIZE)
+// Пустой слот после стирания
+#define PRESET_EMPTY 0xFF
+
+// Раскладка слота (байты). Слот 0 сектора - заголовок: magic, seq, CRC
+enum PresetSlotField {
+  SLOT_ID = 0,
+  SLOT_LIVE = 1,              // 0 = пресет удалён
+  SLOT_NAME = 2,
+  SLOT_MODE = SLOT_NAME + PRESET_NAME_LEN,
+  SLOT_BRIGHTNESS,
+  SLOT_AUTO_SWITCH,           // 2 байта
+  SLOT_RANDOM_ORDER = SLOT_AUTO_SWITCH + 2,
+  SLOT_TRANSITION,            // 2 байта
+  SLOT_SPEED = SLOT_TRANSITION + 2,
+  SLOT_SCALE,
+  SLOT_COLOR1,                // 3 байта
+  SLOT_COLOR2 = SLOT_COLOR1 + 3,
+  SLOT_MODE_BRIGHTNESS = SLOT_COLOR2 + 3,
+  SLOT_PALETTE_SOURCE,
+  SLOT_CRC = PRESET_SLOT_SIZE - 4
+};
+
+static_assert(SLOT_PALETTE_SOURCE < SLOT_CRC, "Preset does not fit into a slot");
+static_assert(MAX_PRESETS < PRESET_SLOTS_PER_SECTOR, "All presets must fit into one sector");
+static_assert(SETTINGS_PRESET_SECTORS >= 2, "Compaction needs a spare sector");
+
+union PresetSlot {
+  uint32_t words[PRESET_SLOT_SIZE / 4];  // Флеш читается и пишется словами
+  uint8_t bytes[PRESET_SLOT_SIZE];
+};
+
+// Слот каждого пресета в текущем секторе, 0 = пресета нет
+static uint8_t presetSlots[MAX_PRESETS];
+// Имя и режим каждого живого пресета: для списка и поиска по имени без флеша
+static char presetNames[MAX_PRESETS][PRESET_NAME_LEN];
+static uint8_t presetModes[MAX_PRESETS];
+static bool indexed = false;     // Сектора пресетов уже просмотрены (indexPresets)
+static volatile bool indexRequested = false;
+static bool haveSector = false;
+static uint8_t currentSector = 0;  // 0..SETTINGS_PRESET_SECTORS-1
+static uint32_t currentSeq = 0;
+static uint8_t nextSlot = 1;
+
+// Запрос от API на запись (см. servicePresets)
+enum PresetRequest : uint8_t { PRESET_REQUEST_NONE, PRESET_REQUEST_SAVE, PRESET_REQUEST_DELETE, PRESET_REQUEST_APPLY };
+static volatile PresetRequest pendingRequest = PRESET_REQUEST_NONE;
+static char requestName[PRESET_NAME_LEN];
+static uint8_t requestId = 0;
+static bool requestSave = false;
+
+static uint32_t slotAddress(uint8_t sector, uint8_t slot) {
+  return settingsSectorAddress(SETTINGS_JOURNAL_SECTORS + sector) + slot * PRESET_SLOT_SIZE;
+}
+
+static bool readSlot(uint8_t sector, uint8_t slot, PresetSlot& data) {
+  return ESP.flashRead(slotAddress(sector, slot), data.words, PRESET_SLOT_SIZE);
+}
+
+static bool slotValid(const PresetSlot& data) {
+  uint32_t crc;
+  memcpy(&crc, data.bytes + SLOT_CRC, sizeof(crc));
+  return data.bytes[SLOT_ID] < MAX_PRESETS && crc == journalCrc32(data.bytes, SLOT_CRC);
+}
+
+static bool writeSlot(uint8_t sector, uint8_t slot, PresetSlot& data) {
+  uint32_t crc = journalCrc32(data.bytes, SLOT_CRC);
+  memcpy(data.bytes + SLOT_CRC, &crc, sizeof(crc));
+  return ESP.flashWrite(slotAddress(sector, slot), data.words, PRESET_SLOT_SIZE);
+}
+
+// Слот стал последним для своего пресета: обновить копию в памяти
+static void indexSlot(const PresetSlot& data, uint8_t slot) {
+  uint8_t id = data.bytes[SLOT_ID];
+  presetSlots[id] = data.bytes[SLOT_LIVE] ? slot : 0;
+  if (presetSlots[id]) {
+    memcpy(presetNames[id], data.bytes + SLOT_NAME, PRESET_NAME_LEN);
+    presetNames[id][PRESET_NAME_LEN - 1] = '\0';
+    presetModes[id] = data.bytes[SLOT_MODE];
+  }
+}
+
+static bool readHeader(uint8_t sector, uint32_t& seq) {
+  PresetSlot header;
+  if (!readSlot(sector, 0, header) || header.words[0] != PRESET_MAGIC ||
+      header.words[2] != journalCrc32(header.words, 8)) {
+    return false;
+  }
+  seq = header.words[1];
+  return true;
+}
+
+// Найти текущий сектор и слоты пресетов. Вызывается при первом обращении
+static void indexPresets() {
+  if (indexed) {
+    return;
+  }
+  indexed = true;
+  memset(presetSlots, 0, sizeof(presetSlots));
+  haveSector = false;
+  if (!journalAvailable()) {
+    return;
+  }
+
+  for (uint8_t s = 0; s < SETTINGS_PRESET_SECTORS; s++) {
+    uint32_t seq;
+    if (readHeader(s, seq) && (!haveSector || (int32_t)(seq - currentSeq) > 0)) {
+      haveSector = true;
+      currentSector = s;
+      currentSeq = seq;
+    }
+  }
+  if (!haveSector) {
+    return;
+  }
+
+  // Слоты дописываются по порядку: более поздний слот пресета главнее
+  nextSlot = PRESET_SLOTS_PER_SECTOR;
+  uint8_t count = 0;
+  for (uint8_t slot = 1; slot < PRESET_SLOTS_PER_SECTOR; slot++) {
+    PresetSlot data;
+    if (!readSlot(currentSector, slot, data)) {
+      break;
+    }
+    if (data.bytes[SLOT_ID] == PRESET_EMPTY && data.bytes[SLOT_LIVE] == PRESET_EMPTY) {
+      nextSlot = slot;
+      break;
+    }
+    // Оборванная запись: слот занят, но пропускается
+    if (slotValid(data)) {
+      indexSlot(data, slot);
+    }
+  }
+  for (uint8_t id = 0; id < MAX_PRESETS; id++) {
+    if (presetSlots[id]) {
+      count++;
+    }
+  }
+  LOG_PRINTF("✅ Presets: %d in sector %d\n", count, currentSector);
+}
+
+// Перенести живые пресеты в другой сектор. Старый сектор остаётся
+// действительным, пока не записан заголовок нового
+static bool compactPresets() {
+  uint8_t sector = haveSector ? (currentSector + 1) % SETTINGS_PRESET_SECTORS : 0;
+  if (!ESP.flashEraseSector(settingsSectorAddress(SETTINGS_JOURNAL_SECTORS + sector) / JOURNAL_SECTOR_SIZE)) {
+    return false;
+  }
+
+  uint8_t slots[MAX_PRESETS];
+  uint8_t slot = 1;
+  for (uint8_t id = 0; id < MAX_PRESETS; id++) {
+    slots[id] = 0;
+    PresetSlot data;
+    if (haveSector && presetSlots[id] && readSlot(currentSector, presetSlots[id], data) && slotValid(data)) {
+      if (!writeSlot(sector, slot, data)) {
+        return false;
+      }
+      slots[id] = slot++;
+    }
+  }
+
+  PresetSlot header;
+  memset(header.bytes, 0xFF, sizeof(header.bytes));
+  header.words[0] = PRESET_MAGIC;
+  header.words[1] = currentSeq + 1;
+  header.words[2] = journalCrc32(header.words, 8);
+  if (!ESP.flashWrite(slotAddress(sector, 0), header.words, 12)) {
+    return false;
+  }
+
+  haveSector = true;
+  currentSector = sector;
+  currentSeq++;
+  nextSlot = slot;
+  memcpy(presetSlots, slots, sizeof(presetSlots));
+  return true;
+}
+
+static bool appendSlot(PresetSlot& data) {
+  if (!journalAvailable()) {
+    return false;
+  }
+  if (!haveSector || nextSlot >= PRESET_SLOTS_PER_SECTOR) {
+    if (!compactPresets() || nextSlot >= PRESET_SLOTS_PER_SECTOR) {
+      return false;
+    }
+  }
+  uint8_t slot = nextSlot++;
+  if (!writeSlot(currentSector, slot, data)) {
+    return false;
+  }
+  indexSlot(data, slot);
+  return true;
+}
+
+bool getPreset(uint8_t id, Preset& preset) {
+  indexPresets();
+  PresetSlot data;
+  if (id >= MAX_PRESETS || !presetSlots[id] || !readSlot(currentSector, presetSlots[id], data) || !slotValid(data)) {
+    return false;
+  }
+  const uint8_t* b = data.bytes;
+  memcpy(preset.name, b + SLOT_NAME, PRESET_NAME_LEN);
+  preset.name[PRESET_NAME_LEN - 1] = '\0';
+  preset.mode = b[SLOT_MODE];
+  preset.brightness = b[SLOT_BRIGHTNESS];
+  preset.autoSwitchDelay = b[SLOT_AUTO_SWITCH] | (b[SLOT_AUTO_SWITCH + 1] << 8);
+  preset.randomOrder = b[SLOT_RANDOM_ORDER];
+  preset.transitionMs = b[SLOT_TRANSITION] | (b[SLOT_TRANSITION + 1] << 8);
+  preset.modeSettings.speed = b[SLOT_SPEED];
+  preset.modeSettings.scale = b[SLOT_SCALE];
+  preset.modeSettings.color1 = CRGB(b[SLOT_COLOR1], b[SLOT_COLOR1 + 1], b[SLOT_COLOR1 + 2]);
+  preset.modeSettings.color2 = CRGB(b[SLOT_COLOR2], b[SLOT_COLOR2 + 1], b[SLOT_COLOR2 + 2]);
+  preset.modeSettings.brightness = b[SLOT_MODE_BRIGHTNESS];
+  preset.modeSettings.archived = false;
+  preset.paletteSource = b[SLOT_PALETTE_SOURCE];
+  return true;
+}
+
+bool requestPresetIndex() {
+  if (!indexed) {
+    indexRequested = true;
+  }
+  return indexed;
+}
+
+const char* presetName(uint8_t id) {
+  return id < MAX_PRESETS && presetSlots[id] ? presetNames[id] : nullptr;
+}
+
+uint8_t presetMode(uint8_t id) {
+  return id < MAX_PRESETS ? presetModes[id] : 0;
+}
+
+int8_t findPreset(const char* name) {
+  indexPresets();
+  for (uint8_t id = 0; id < MAX_PRESETS; id++) {
+    if (presetSlots[id] && strcmp(presetNames[id], name) == 0) {
+      return id;
+    }
+  }
+  return -1;
+}
+
+int8_t savePreset(const char* name) {
+  indexPresets();
+  int8_t id = findPreset(name);
+  for (uint8_t i = 0; id < 0 && i < MAX_PRESETS; i++) {
+    if (!presetSlots[i]) {
+      id = i;
+    }
+  }
+  if (id < 0) {
+    return -1;
+  }
+
+  const ModeSettings& settings = ledState.modeSettings[ledState.currentMode];
+  PresetSlot data;
+  memset(data.bytes, 0xFF, sizeof(data.bytes));
+  uint8_t* b = data.bytes;
+  b[SLOT_ID] = id;
+  b[SLOT_LIVE] = 1;
+  memset(b + SLOT_NAME, 0, PRESET_NAME_LEN);
+  strncpy((char*)b + SLOT_NAME, name, PRESET_NAME_LEN - 1);
+  b[SLOT_MODE] = ledState.currentMode;
+  b[SLOT_BRIGHTNESS] = ledState.brightness;
+  b[SLOT_AUTO_SWITCH] = ledState.autoSwitchDelay & 0xFF;
+  b[SLOT_AUTO_SWITCH + 1] = ledState.autoSwitchDelay >> 8;
+  b[SLOT_RANDOM_ORDER] = ledState.randomOrder;
+  b[SLOT_TRANSITION] = ledState.transitionMs & 0xFF;
+  b[SLOT_TRANSITION + 1] = ledState.transitionMs >> 8;
+  b[SLOT_SPEED] = settings.speed;
+  b[SLOT_SCALE] = settings.scale;
+  b[SLOT_COLOR1] = settings.color1.r;
+  b[SLOT_COLOR1 + 1] = settings.color1.g;
+  b[SLOT_COLOR1 + 2] = settings.color1.b;
+  b[SLOT_COLOR2] = settings.color2.r;
+  b[SLOT_COLOR2 + 1] = settings.color2.g;
+  b[SLOT_COLOR2 + 2] = settings.color2.b;
+  b[SLOT_MODE_BRIGHTNESS] = settings.brightness;
+  b[SLOT_PALETTE_SOURCE] = ledState.paletteSource[ledState.currentMode];
+  return appendSlot(data) ? id : -1;
+}
+
+bool deletePreset(uint8_t id) {
+  indexPresets();
+  if (id >= MAX_PRESETS || !presetSlots[id]) {
+    return false;
+  }
+  PresetSlot data;
+  memset(data.bytes, 0xFF, sizeof(data.bytes));
+  data.bytes[SLOT_ID] = id;
+  data.bytes[SLOT_LIVE] = 0;
+  return appendSlot(data);
+}
+
+bool applyPreset(uint8_t id) {
+  Preset preset;
+  if (!getPreset(id, preset) || preset.mode >= TOTAL_MODES) {
+    return false;
+  }
+  // Всё меняется между двумя кадрами: runMode() увидит новый режим
+  // вместе с его настройками и начнёт обычный переход
+  ModeSettings& settings = ledState.modeSettings[preset.mode];
+  bool archived = settings.archived;
+  settings = preset.modeSettings;
+  settings.archived = archived;
+  ledState.paletteSource[preset.mode] = preset.paletteSource;
+  ledState.brightness = preset.brightness;
+  ledState.autoSwitchDelay = preset.autoSwitchDelay;
+  ledState.randomOrder = preset.randomOrder;
+  ledState.transitionMs = preset.transitionMs;
+  ledState.currentMode = preset.mode;
+  invalidatePalettes();
+  return true;
+}
+
+bool requestPresetSave(const char* name) {
+  if (pendingRequest != PRESET_REQUEST_NONE) {
+    return false;
+  }
+  strncpy(requestName, name, PRESET_NAME_LEN - 1);
+  requestName[PRESET_NAME_LEN - 1] = '\0';
+  pendingRequest = PRESET_REQUEST_SAVE;
+  return true;
+}
+
+bool requestPresetDelete(uint8_t id) {
+  if (pendingRequest != PRESET_REQUEST_NONE) {
+    return false;
+  }
+  requestId = id;
+  pendingRequest = PRESET_REQUEST_DELETE;
+  return true;
+}
+
+bool requestPresetApply(uint8_t id, bool save) {
+  if (pendingRequest != PRESET_REQUEST_NONE) {
+    return false;
+  }
+  requestId = id;
+  requestSave = save;
+  pendingRequest = PRESET_REQUEST_APPLY;
+  return true;
+}
+
+void servicePresets() {
+  if (indexRequested) {
+    indexPresets();
+    indexRequested = false;
+  }
+
+  if (pendingRequest == PRESET_REQUEST_SAVE) {
+    int8_t id = savePreset(requestName);
+    if (id < 0) {
+      LOG_PRINTF("❌ Failed to save preset \"%s\"\n", requestName);
+    } else {
+      LOG_PRINTF("💾 Preset %d \"%s\" saved\n", id, requestName);
+    }
+  } else if (pendingRequest == PRESET_REQUEST_DELETE) {
+    if (!deletePreset(requestId)) {
+      LOG_PRINTF("❌ Failed to delete preset %d\n", requestId);
+    }
+  } else if (pendingRequest == PRESET_REQUEST_APPLY) {
+    if (!applyPreset(requestId)) {
+      LOG_PRINTF("❌ Failed to apply preset %d\n", requestId);
+    } else if (requestSave) {
+      settingsChanged = true;
+    }
+  }
+  pendingRequest = PRESET_REQUEST_NONE;
+}
@@ -0,0 +1,65 @@
+#ifndef PRESET_STORE_H
+#define PRESET_STORE_H
+
+#include <Arduino.h>
+#include "led_state.h"
+
+// Именованные пресеты: режим, его настройки и палитра, общая яркость,
+// авто-переключение и переход. Хранятся во флеше за журналом настроек
+// (SETTINGS_PRESET_SECTORS секторов), по слоту на пресет. Изменение
+// дописывает новый слот, сектор стирается только при уплотнении, когда
+// слоты кончились. В памяти - номер слота, имя и режим каждого пресета:
+// обработчики API отвечают по ним и не читают флеш из async колбэка.
+// Флеш просматривается при первом обращении к пресетам, а не при старте:
+// тёплый старт (rtc_state.h) не читает флеш вовсе.
+
+#define MAX_PRESETS 32
+#define PRESET_NAME_LEN 32  // Байт UTF-8 с завершающим нулём
+
+struct Preset {
+  char name[PRESET_NAME_LEN];
+  uint8_t mode;
+  uint8_t brightness;         // Общая яркость
+  uint16_t autoSwitchDelay;
+  bool randomOrder;
+  uint16_t transitionMs;
+  ModeSettings modeSettings;  // Настройки режима mode (archived не меняется)
+  uint8_t paletteSource;
+};
+
+// Копия списка пресетов в памяти готова? Если нет, просмотр флеша
+// выполнит loop() (servicePresets()), а обработчик API отвечает "повторите"
+bool requestPresetIndex();
+
+// Имя пресета из копии в памяти, nullptr - пресета нет. Флеш не читается
+const char* presetName(uint8_t id);
+
+// Режим пресета из копии в памяти
+uint8_t presetMode(uint8_t id);
+
+// Номер пресета с таким именем или -1. Флеш не читается
+int8_t findPreset(const char* name);
+
+// Прочитать пресет из флеша. false - пресета нет или слот испорчен
+bool getPreset(uint8_t id, Preset& preset);
+
+// Сохранить текущее состояние под именем name (существующий пресет
+// с тем же именем перезаписывается). Возвращает номер или -1
+int8_t savePreset(const char* name);
+
+bool deletePreset(uint8_t id);
+
+// Запись во флеш и чтение пресета для применения выполняет loop()
+// (servicePresets()), обработчики API только ставят запрос.
+// false - предыдущий запрос ещё не выполнен
+bool requestPresetSave(const char* name);
+bool requestPresetDelete(uint8_t id);
+// save - сохранить результат в настройки (settingsChanged)
+bool requestPresetApply(uint8_t id, bool save);
+void servicePresets();
+
+// Применить пресет к ledState. Ничего не сохраняет: для записи
+// во флеш вызывающий сам выставляет settingsChanged
+bool applyPreset(uint8_t id);
+
+#endif
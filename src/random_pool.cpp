@@ -0,0 +1,29 @@
+#include "random_pool.h"
+
+uint8_t randomPool[RANDOM_POOL_SIZE];
+uint8_t randomPoolPos = 0;  // 0 = пул израсходован, следующий вызов его заполнит
+
+static uint32_t xorshiftState = 2463534242UL;
+
+void seedRandomPool(uint32_t seed) {
+  xorshiftState = seed ? seed : 2463534242UL;  // Нулевое состояние xorshift не покидает
+  randomPoolPos = 0;
+}
+
+uint32_t randomPoolState() {
+  return xorshiftState;
+}
+
+void refillRandomPool() {
+  uint32_t x = xorshiftState;
+  for (uint16_t i = 0; i < RANDOM_POOL_SIZE; i += 4) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randomPool[i] = x;
+    randomPool[i + 1] = x >> 8;
+    randomPool[i + 2] = x >> 16;
+    randomPool[i + 3] = x >> 24;
+  }
+  xorshiftState = x;
+}
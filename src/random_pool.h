@@ -0,0 +1,53 @@
+#ifndef RANDOM_POOL_H
+#define RANDOM_POOL_H
+
+#include <Arduino.h>
+
+// Пул случайных байт для режимов. xorshift32 заполняет его пачкой по
+// RANDOM_POOL_SIZE байт, а poolRandom8() - это чтение байта и сдвиг индекса
+// вместо отдельного random8() на каждый вызов. С одинаковым seed режимы
+// дают одинаковые кадры (бенчмарк, сравнение дампов).
+
+// Размер пула: индекс uint8_t переполняется ровно на конце буфера
+#define RANDOM_POOL_SIZE 256
+
+extern uint8_t randomPool[RANDOM_POOL_SIZE];
+extern uint8_t randomPoolPos;
+
+// Задать seed и сбросить пул
+void seedRandomPool(uint32_t seed);
+
+// Состояние генератора: seedRandomPool(randomPoolState()) продолжает
+// последовательность со следующего заполнения пула (кэш в RTC, rtc_state.h)
+uint32_t randomPoolState();
+
+// Заполнить пул следующими RANDOM_POOL_SIZE байтами
+void refillRandomPool();
+
+inline uint8_t poolRandom8() {
+  if (randomPoolPos == 0) {
+    refillRandomPool();
+  }
+  return randomPool[randomPoolPos++];
+}
+
+// [0, lim), как random8(lim)
+inline uint8_t poolRandom8(uint8_t lim) {
+  return ((uint16_t)poolRandom8() * lim) >> 8;
+}
+
+// [min, max), как random8(min, max)
+inline uint8_t poolRandom8(uint8_t min, uint8_t max) {
+  return min + poolRandom8(max - min);
+}
+
+inline uint16_t poolRandom16() {
+  return ((uint16_t)poolRandom8() << 8) | poolRandom8();
+}
+
+// [0, lim), как random16(lim)
+inline uint16_t poolRandom16(uint16_t lim) {
+  return ((uint32_t)poolRandom16() * lim) >> 16;
+}
+
+#endif
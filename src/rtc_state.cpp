@@ -0,0 +1,147 @@
+#include "rtc_state.h"
+#include "config.h"
+#include "led_state.h"
+#include "led_modes.h"
+#include "random_pool.h"
+#include "settings_schema.h"
+#include "settings_journal.h"
+#include "logger.h"
+#include <stddef.h>
+#include <time.h>
+#ifndef NATIVE_BUILD
+#include <user_interface.h>  // rst_info, REASON_*
+#endif
+
+#define RTC_STATE_MAGIC 0x5244454C  // "LEDR"
+#define RTC_USER_MEMORY_SIZE 512
+
+struct RtcStateHeader {
+  uint32_t magic;
+  uint32_t crc;          // CRC32 всего после этого поля: остаток заголовка и length байт TLV
+  uint16_t length;       // Длина TLV
+  uint8_t version;       // Версия TLV (EEPROM_VERSION записавшей прошивки)
+  uint8_t crashBoots;
+  uint32_t animMs;       // animClock.ms
+  uint32_t randomState;  // randomPoolState()
+  uint32_t unixTime;     // time(nullptr), 0 - время не было синхронизировано
+  uint8_t unsaved;       // Изменения ещё не записаны во флеш
+  uint8_t scheduleMinute;  // lastCheckedMinute + 1 (0 - расписания ещё не проверялись)
+  uint8_t reserved[2];
+};
+
+// TLV сразу за заголовком: RTC память читается и пишется блоками по 4 байта
+struct RtcImage {
+  RtcStateHeader header;
+  uint8_t tlv[(SCHEMA_ENCODED_SIZE + 3) & ~3];
+};
+
+static_assert(sizeof(RtcStateHeader) % 4 == 0, "RTC state header must be a whole number of blocks");
+static_assert(sizeof(RtcImage) <= RTC_USER_MEMORY_SIZE - RTC_STATE_OFFSET * 4,
+              "RTC state does not fit into RTC user memory");
+
+RtcStateStats rtcStateStats = {false, 0, 0};
+
+alignas(4) static RtcImage image;
+static uint32_t lastWriteMs = 0;
+
+static uint16_t align4(uint16_t length) {
+  return (length + 3) & ~3;
+}
+
+static uint32_t imageCrc(uint16_t length) {
+  const uint8_t* start = (const uint8_t*)&image.header.length;
+  return journalCrc32(start, sizeof(RtcStateHeader) - offsetof(RtcStateHeader, length) + length);
+}
+
+void saveRtcState() {
+  uint16_t length = encodeLEDState(image.tlv, sizeof(image.tlv));
+  if (length == 0) {
+    return;
+  }
+  memset(image.tlv + length, 0, align4(length) - length);
+
+  // Проработали достаточно - прошлые падения не в счёт
+  if (rtcStateStats.crashBoots > 0 && millis() >= RTC_STATE_STABLE_MS) {
+    rtcStateStats.crashBoots = 0;
+  }
+
+  time_t now = time(nullptr);
+  image.header.magic = RTC_STATE_MAGIC;
+  image.header.length = length;
+  image.header.version = EEPROM_VERSION;
+  image.header.crashBoots = rtcStateStats.crashBoots;
+  image.header.animMs = animClock.ms;
+  image.header.randomState = randomPoolState();
+  image.header.unixTime = now > 1000000000 ? (uint32_t)now : 0;
+  image.header.unsaved = settingsChanged || saveStats.pendingChanges > 0;
+  image.header.scheduleMinute = lastCheckedMinute + 1;
+  memset(image.header.reserved, 0, sizeof(image.header.reserved));
+  image.header.crc = imageCrc(length);
+
+  ESP.rtcUserMemoryWrite(RTC_STATE_OFFSET, (uint32_t*)&image, sizeof(RtcStateHeader) + align4(length));
+  rtcStateStats.writes++;
+  lastWriteMs = millis();
+}
+
+void serviceRtcState() {
+  if (millis() - lastWriteMs >= RTC_STATE_INTERVAL_MS) {
+    saveRtcState();
+  }
+}
+
+bool restoreRtcState() {
+  uint32_t reason = ESP.getResetInfoPtr()->reason;
+  bool crash = reason == REASON_WDT_RST || reason == REASON_EXCEPTION_RST || reason == REASON_SOFT_WDT_RST;
+  if (!crash && reason != REASON_SOFT_RESTART) {
+    return false;  // Включение питания, кнопка RST, пробуждение: RTC память не наша
+  }
+
+  if (!ESP.rtcUserMemoryRead(RTC_STATE_OFFSET, (uint32_t*)&image.header, sizeof(RtcStateHeader)) ||
+      image.header.magic != RTC_STATE_MAGIC || image.header.length > sizeof(image.tlv)) {
+    return false;
+  }
+  uint16_t length = image.header.length;
+  if (!ESP.rtcUserMemoryRead(RTC_STATE_OFFSET + sizeof(RtcStateHeader) / 4, (uint32_t*)image.tlv, align4(length)) ||
+      image.header.crc != imageCrc(length)) {
+    LOG_PRINTLN("⚠️ RTC state damaged, cold start");
+    return false;
+  }
+
+  // Если падает само состояние, тёплые старты по кругу не помогут
+  uint8_t crashBoots = image.header.crashBoots;
+  if (crash) {
+    if (crashBoots >= RTC_STATE_MAX_CRASH_BOOTS) {
+      LOG_PRINTF("⚠️ %d crashes in a row, ignoring RTC state\n", crashBoots);
+      return false;
+    }
+    crashBoots++;
+  }
+
+  if (!decodeLEDState(image.tlv, length, image.header.version)) {
+    LOG_PRINTF("⚠️ Unsupported RTC state (v%d), cold start\n", image.header.version);
+    return false;
+  }
+
+  animClock.ms = image.header.animMs;
+  seedRandomPool(image.header.randomState);
+  if (image.header.unixTime != 0 && time(nullptr) < 1000000000) {
+    // Отстаёт на время перезагрузки, NTP поправит
+    timeval tv = { (time_t)image.header.unixTime, 0 };
+    settimeofday(&tv, nullptr);
+  }
+  // Расписание, сработавшее в эту минуту до сброса, не срабатывает второй раз
+  lastCheckedMinute = (int)image.header.scheduleMinute - 1;
+  // Несохранённое до сброса - обратно в очередь отложенной записи
+  if (image.header.unsaved) {
+    settingsChanged = true;
+  }
+
+  rtcStateStats.warmBoot = true;
+  rtcStateStats.crashBoots = crashBoots;
+  LOG_PRINTF("♻️ Warm start: state restored from RTC memory (mode %d, crashes in a row: %d)\n",
+             ledState.currentMode, crashBoots);
+
+  // Счётчик падений должен пережить следующий сброс, даже если он случится в setup()
+  saveRtcState();
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef RTC_STATE_H
+#define RTC_STATE_H
+
+#include <Arduino.h>
+
+// Горячее состояние в пользовательской RTC памяти ESP8266: она переживает
+// программный сброс (WDT, исключение, ESP.restart(), перезагрузку после OTA),
+// но не отключение питания. В образе - ledState в TLV (settings_schema.h)
+// с режимом, который показывало авто-переключение, и ещё не сохранёнными
+// изменениями, часы анимации, состояние пула случайных чисел, время суток
+// и минута последней проверки расписаний.
+// Образ защищён CRC32 и обновляется из loop() раз в RTC_STATE_INTERVAL_MS.
+
+// Статистика (для /api/debug)
+struct RtcStateStats {
+  bool warmBoot;       // Состояние при старте взято из RTC памяти
+  uint8_t crashBoots;  // Сбросов по WDT/исключению подряд
+  uint32_t writes;     // Записей образа с момента загрузки
+};
+
+extern RtcStateStats rtcStateStats;
+
+// Минута последней проверки расписаний (main.cpp), -1 - ещё не проверялись
+extern int lastCheckedMinute;
+
+// Тёплый старт: сброс программный и в RTC целый образ. Восстанавливает
+// ledState, часы анимации, пул случайных чисел и время, флеш не читается.
+// Иначе (включение питания, кнопка RST, испорченный образ, больше
+// RTC_STATE_MAX_CRASH_BOOTS падений подряд) возвращает false, ledState не тронут
+bool restoreRtcState();
+
+// Записать образ в RTC память сейчас (после смены режима, перед перезагрузкой)
+void saveRtcState();
+
+// Вызывается из loop(): saveRtcState() раз в RTC_STATE_INTERVAL_MS
+void serviceRtcState();
+
+#endif
@@ -0,0 +1,522 @@
+#include "settings_journal.h"
+#include <stddef.h>
+
+#ifndef NATIVE_BUILD
+// Раздел файловой системы из ld-скрипта (на d1_mini по умолчанию 2 МБ).
+// LittleFS в прошивке не используется, журнал занимает его первые сектора.
+extern "C" uint32_t _FS_start;
+extern "C" uint32_t _FS_end;
+#define JOURNAL_FLASH_BASE 0x40200000
+#endif
+
+#define JOURNAL_MAGIC 0x4A44454C  // "LEDJ"
+// Пустая флеш после стирания: заголовок записи 0xFFFF = конец журнала
+#define JOURNAL_END 0xFFFF
+// Смещение записи-отметки (длина 0): записи до неё - одно завершённое сохранение
+#define JOURNAL_COMMIT 0xFFFE
+// Формат записей сектора (JournalHeader::format): сохранение применяется только целиком, по отметке
+#define JOURNAL_FORMAT 0x01
+// Изменения ближе этого сливаются в одну запись: разрыв дешевле обрамления
+#define JOURNAL_MERGE_GAP JOURNAL_RECORD_OVERHEAD
+// Данные записи читаются и пишутся кусками, без буфера на всю запись
+#define JOURNAL_CHUNK 64
+
+struct JournalHeader {
+  uint32_t magic;
+  uint32_t seq;         // Растёт при каждом уплотнении
+  uint16_t stateSize;   // Размер снимка
+  uint8_t version;      // Версия структуры состояния (EEPROM_VERSION)
+  uint8_t format;       // JOURNAL_FORMAT
+  uint32_t crc;         // CRC32 полей выше
+};
+
+struct JournalRecordHead {
+  uint16_t offset;      // Смещение в состоянии, JOURNAL_END = конец журнала, JOURNAL_COMMIT = отметка
+  uint16_t length;      // Длина данных, за ними выравнивание 0xFF и CRC32
+};
+
+static_assert(sizeof(JournalHeader) == JOURNAL_HEADER_SIZE, "JournalHeader layout");
+static_assert(sizeof(JournalRecordHead) + 4 == JOURNAL_RECORD_OVERHEAD, "JournalRecordHead layout");
+static_assert(JOURNAL_CHUNK % 4 == 0, "flash access must be 4-byte aligned");
+
+JournalStats journalStats = {0, 0, 0, 0, 0};
+
+// Текущий сектор. Если журнала во флеше нет, первое сохранение пишет снимок в сектор 0
+static bool haveSector = false;
+static uint8_t currentSector = 0;
+static uint32_t currentSeq = 0;
+static uint8_t currentVersion = 0;
+static uint16_t currentSize = 0;
+static uint16_t writePos = 0;
+static bool needCompact = false;  // Хвост сектора испорчен или не завершён - дописывать нельзя
+static uint32_t highestSeq = 0;   // Наибольший номер среди заголовков: следующий снимок новее всех
+static bool indexed = false;      // Сектора уже просмотрены (journalLoad/journalIndex)
+
+// Последнее сохранённое состояние: с ним сравнивается новое
+static uint8_t* shadow = nullptr;
+static uint16_t shadowSize = 0;
+
+static uint32_t chunkBuf[JOURNAL_CHUNK / 4];
+
+uint32_t journalCrc32(const void* data, size_t length, uint32_t crc) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  crc = ~crc;
+  while (length--) {
+    crc ^= *bytes++;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static inline uint16_t align4(uint16_t value) {
+  return (value + 3) & ~3;
+}
+
+// Длина очередного куска данных записи
+static inline uint16_t chunkLength(uint16_t length, uint16_t done) {
+  return length - done < JOURNAL_CHUNK ? length - done : JOURNAL_CHUNK;
+}
+
+static inline uint16_t recordSize(uint16_t length) {
+  return JOURNAL_RECORD_OVERHEAD + align4(length);
+}
+
+uint32_t settingsSectorAddress(uint8_t sector) {
+#ifdef NATIVE_BUILD
+  return (uint32_t)sector * JOURNAL_SECTOR_SIZE;
+#else
+  return ((uint32_t)&_FS_start - JOURNAL_FLASH_BASE) + (uint32_t)sector * JOURNAL_SECTOR_SIZE;
+#endif
+}
+
+bool journalAvailable() {
+#ifdef NATIVE_BUILD
+  return true;
+#else
+  return (uint32_t)&_FS_end - (uint32_t)&_FS_start >= SETTINGS_AREA_SECTORS * JOURNAL_SECTOR_SIZE;
+#endif
+}
+
+static uint32_t headerCrc(const JournalHeader& header) {
+  return journalCrc32(&header, offsetof(JournalHeader, crc));
+}
+
+// Флеш читается и пишется словами по выровненному адресу в RAM, а у
+// JournalHeader и JournalRecordHead выравнивание может быть меньше 4:
+// они идут через буфер uint32_t
+static bool readHeader(uint8_t sector, JournalHeader& header) {
+  uint32_t words[JOURNAL_HEADER_SIZE / 4];
+  if (!ESP.flashRead(settingsSectorAddress(sector), words, sizeof(words))) {
+    return false;
+  }
+  memcpy(&header, words, sizeof(header));
+  return header.magic == JOURNAL_MAGIC && header.crc == headerCrc(header) &&
+         header.format == JOURNAL_FORMAT && header.stateSize > 0 && header.stateSize <= JOURNAL_MAX_STATE_SIZE;
+}
+
+static bool readHead(uint32_t address, JournalRecordHead& head) {
+  uint32_t word;
+  if (!ESP.flashRead(address, &word, sizeof(word))) {
+    return false;
+  }
+  memcpy(&head, &word, sizeof(head));
+  return true;
+}
+
+// Проверить запись: данные читаются кусками и проходят через CRC.
+// В state ничего не пишется, пока CRC не сошёлся
+static bool checkRecord(uint32_t address, const JournalRecordHead& head) {
+  uint32_t crc = journalCrc32(&head, sizeof(head));
+  uint32_t data = address + sizeof(head);
+  for (uint16_t done = 0; done < head.length; done += JOURNAL_CHUNK) {
+    uint16_t n = chunkLength(head.length, done);
+    if (!ESP.flashRead(data + done, chunkBuf, align4(n))) {
+      return false;
+    }
+    crc = journalCrc32(chunkBuf, n, crc);
+  }
+  uint32_t stored;
+  if (!ESP.flashRead(data + align4(head.length), &stored, sizeof(stored))) {
+    return false;
+  }
+  return stored == crc;
+}
+
+// Скопировать проверенную запись в state (только то, что в него помещается)
+static void applyRecord(uint32_t address, const JournalRecordHead& head, uint8_t* state, uint16_t size) {
+  uint32_t data = address + sizeof(head);
+  for (uint16_t done = 0; done < head.length; done += JOURNAL_CHUNK) {
+    uint16_t n = chunkLength(head.length, done);
+    uint16_t target = head.offset + done;
+    if (target >= size) {
+      break;
+    }
+    ESP.flashRead(data + done, chunkBuf, align4(n));
+    memcpy(state + target, chunkBuf, size - target < n ? size - target : n);
+  }
+}
+
+static bool writeRecord(uint32_t address, uint16_t offset, const uint8_t* data, uint16_t length) {
+  JournalRecordHead head = {offset, length};
+  uint32_t crc = journalCrc32(data, length, journalCrc32(&head, sizeof(head)));
+
+  // Заголовок первым: оборванная дальше запись не пройдёт CRC
+  uint32_t headWord;
+  memcpy(&headWord, &head, sizeof(head));
+  if (!ESP.flashWrite(address, &headWord, sizeof(headWord))) {
+    return false;
+  }
+  address += sizeof(head);
+  for (uint16_t done = 0; done < length; done += JOURNAL_CHUNK) {
+    uint16_t n = chunkLength(length, done);
+    memset(chunkBuf, 0xFF, sizeof(chunkBuf));
+    memcpy(chunkBuf, data + done, n);
+    if (!ESP.flashWrite(address + done, chunkBuf, align4(n))) {
+      return false;
+    }
+  }
+  return ESP.flashWrite(address + align4(length), &crc, sizeof(crc));
+}
+
+static void updateShadow(const void* state, uint16_t size) {
+  if (shadowSize != size) {
+    free(shadow);
+    shadow = (uint8_t*)malloc(size);
+    shadowSize = shadow ? size : 0;
+  }
+  if (shadow) {
+    memcpy(shadow, state, size);
+  }
+}
+
+static void updateStats() {
+  journalStats.seq = currentSeq;
+  journalStats.sector = currentSector;
+  journalStats.usedBytes = writePos;
+}
+
+// Записи сектора: где кончаются снимок, последнее завершённое сохранение
+// и целые записи
+struct SectorScan {
+  uint16_t snapshotEnd;
+  uint16_t committed;
+  uint16_t end;
+  bool torn;            // За end испорченная запись
+};
+
+// Пройти записи сектора, проверяя CRC. Возвращает false, если снимок испорчен
+static bool scanSector(uint8_t sector, const JournalHeader& header, SectorScan& scan) {
+  uint32_t base = settingsSectorAddress(sector);
+  uint16_t pos = JOURNAL_HEADER_SIZE;
+  bool snapshot = true;
+  scan = {0, 0, 0, false};
+
+  while (pos + JOURNAL_RECORD_OVERHEAD <= JOURNAL_SECTOR_SIZE) {
+    JournalRecordHead head;
+    if (!readHead(base + pos, head)) {
+      scan.torn = true;
+      break;
+    }
+    if (head.offset == JOURNAL_END && head.length == JOURNAL_END) {
+      break;
+    }
+    // Первая запись - полный снимок, дальше - изменения внутри него и отметки
+    bool commit = head.offset == JOURNAL_COMMIT && head.length == 0;
+    bool valid = snapshot ? (head.offset == 0 && head.length == header.stateSize)
+                          : commit || (head.length > 0 && (uint32_t)head.offset + head.length <= header.stateSize);
+    valid = valid && pos + recordSize(head.length) <= JOURNAL_SECTOR_SIZE && checkRecord(base + pos, head);
+    if (!valid) {
+      if (snapshot) {
+        return false;
+      }
+      scan.torn = true;
+      break;
+    }
+    pos += recordSize(head.length);
+    if (snapshot) {
+      scan.snapshotEnd = pos;
+    }
+    // Снимок завершён сам, изменения - отметкой
+    if (snapshot || commit) {
+      scan.committed = pos;
+    }
+    snapshot = false;
+  }
+  if (snapshot) {
+    return false;
+  }
+  scan.end = pos;
+  return true;
+}
+
+// Собрать в state снимок и изменения сектора до позиции until
+static void applySector(uint8_t sector, uint16_t until, uint8_t* state, uint16_t size) {
+  uint32_t base = settingsSectorAddress(sector);
+  for (uint16_t pos = JOURNAL_HEADER_SIZE; pos < until; ) {
+    JournalRecordHead head;
+    readHead(base + pos, head);
+    if (head.length > 0) {
+      applyRecord(base + pos, head, state, size);
+    }
+    pos += recordSize(head.length);
+  }
+}
+
+// Конец сохранения, завершённого раньше позиции until; самое раннее -
+// снимок, до него - 0. Записи уже проверены scanSector()
+static uint16_t previousCommit(uint8_t sector, const SectorScan& scan, uint16_t until) {
+  if (until <= scan.snapshotEnd) {
+    return 0;
+  }
+  uint32_t base = settingsSectorAddress(sector);
+  uint16_t found = scan.snapshotEnd;
+  for (uint16_t pos = scan.snapshotEnd; pos < until; ) {
+    JournalRecordHead head;
+    readHead(base + pos, head);
+    pos += recordSize(head.length);
+    if (pos < until && head.offset == JOURNAL_COMMIT) {
+      found = pos;
+    }
+  }
+  return found;
+}
+
+// Сделать sector текущим: сохранения дописываются в него с позиции end
+static void useSector(uint8_t sector, const JournalHeader& header, const SectorScan& scan) {
+  haveSector = true;
+  currentSector = sector;
+  currentSeq = header.seq;
+  currentVersion = header.version;
+  currentSize = header.stateSize;
+  writePos = scan.end;
+  // Незавершённое сохранение в хвосте нельзя продолжать: следующая отметка
+  // применила бы и его
+  needCompact = scan.torn || scan.end != scan.committed;
+}
+
+// Всё о секторах - заново из флеши: заголовки всех секторов и наибольший номер.
+// Возвращает false, если области журнала нет
+static bool readHeaders(JournalHeader* headers, bool* valid) {
+  indexed = true;
+  haveSector = false;
+  needCompact = false;
+  highestSeq = 0;
+
+  if (!journalAvailable()) {
+    Serial.println("❌ Flash has no filesystem area for the settings journal");
+    return false;
+  }
+  for (uint8_t s = 0; s < SETTINGS_JOURNAL_SECTORS; s++) {
+    valid[s] = readHeader(s, headers[s]);
+    if (valid[s] && (int32_t)(headers[s].seq - highestSeq) > 0) {
+      highestSeq = headers[s].seq;
+    }
+  }
+  return true;
+}
+
+// Самый новый из ещё не отброшенных секторов, -1 - таких нет
+static int8_t newestSector(const JournalHeader* headers, const bool* valid) {
+  int8_t best = -1;
+  for (uint8_t s = 0; s < SETTINGS_JOURNAL_SECTORS; s++) {
+    if (valid[s] && (best < 0 || (int32_t)(headers[s].seq - headers[best].seq) > 0)) {
+      best = s;
+    }
+  }
+  return best;
+}
+
+bool journalIndex() {
+  JournalHeader headers[SETTINGS_JOURNAL_SECTORS];
+  bool valid[SETTINGS_JOURNAL_SECTORS];
+  if (!readHeaders(headers, valid)) {
+    return false;
+  }
+
+  for (int8_t best = newestSector(headers, valid); best >= 0; best = newestSector(headers, valid)) {
+    valid[best] = false;
+    const JournalHeader& header = headers[best];
+    SectorScan scan;
+    if (!scanSector(best, header, scan)) {
+      continue;
+    }
+    // Новое состояние сравнивается с тем, что во флеше на самом деле
+    if (shadowSize != header.stateSize) {
+      free(shadow);
+      shadow = (uint8_t*)malloc(header.stateSize);
+      shadowSize = shadow ? header.stateSize : 0;
+    }
+    if (shadow) {
+      applySector(best, scan.committed, shadow, shadowSize);
+    }
+    useSector(best, header, scan);
+    updateStats();
+    return true;
+  }
+  return false;
+}
+
+bool journalLoad(void* state, uint16_t size, uint8_t& version, uint16_t& loadedSize, JournalAccept accept) {
+  JournalHeader headers[SETTINGS_JOURNAL_SECTORS];
+  bool valid[SETTINGS_JOURNAL_SECTORS];
+  if (!readHeaders(headers, valid)) {
+    return false;
+  }
+
+  // От нового сектора к старому, в секторе - от последнего сохранения
+  // к снимку, с которого сектор начинается
+  uint8_t* bytes = (uint8_t*)state;
+  bool fallback = false;
+  for (int8_t best = newestSector(headers, valid); best >= 0; best = newestSector(headers, valid)) {
+    valid[best] = false;
+
+    const JournalHeader& header = headers[best];
+    SectorScan scan;
+    if (!scanSector(best, header, scan)) {
+      Serial.printf("⚠️ Settings journal: sector %d is damaged, trying older one\n", best);
+      fallback = true;
+      continue;
+    }
+    uint16_t acceptSize = header.stateSize < size ? header.stateSize : size;
+    for (uint16_t until = scan.committed; until != 0; until = previousCommit(best, scan, until)) {
+      applySector(best, until, bytes, size);
+      if (accept && !accept(bytes, acceptSize, header.version)) {
+        Serial.printf("⚠️ Settings journal: state at %d in sector %d rejected\n", until, best);
+        fallback = true;
+        continue;
+      }
+
+      useSector(best, header, scan);
+      // Отвергнутое осталось во флеше: дописывать к нему нельзя, только новый снимок
+      needCompact = needCompact || fallback;
+      version = currentVersion;
+      loadedSize = currentSize;
+      updateShadow(state, size);
+      updateStats();
+      if (fallback) {
+        Serial.printf("⚠️ Settings journal: restored an older state from sector %d\n", best);
+      } else if (needCompact) {
+        Serial.printf("⚠️ Settings journal: sector %d has an unfinished save, will compact\n", currentSector);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+// Новый снимок в следующий сектор. Старый сектор не трогается,
+// пока заголовок нового не записан, поэтому сбой питания не теряет настройки
+static bool compact(const void* state, uint16_t size, uint8_t version) {
+  // Без просмотра секторов "сектор 0, номер 1" затёр бы настройки старым номером
+  if (!indexed) {
+    journalIndex();
+  }
+  uint8_t sector = haveSector ? (currentSector + 1) % SETTINGS_JOURNAL_SECTORS : 0;
+  uint32_t base = settingsSectorAddress(sector);
+
+  if (!ESP.flashEraseSector(base / JOURNAL_SECTOR_SIZE)) {
+    return false;
+  }
+  if (!writeRecord(base + JOURNAL_HEADER_SIZE, 0, (const uint8_t*)state, size)) {
+    return false;
+  }
+
+  JournalHeader header;
+  header.magic = JOURNAL_MAGIC;
+  header.seq = highestSeq + 1;
+  header.stateSize = size;
+  header.version = version;
+  header.format = JOURNAL_FORMAT;
+  header.crc = headerCrc(header);
+  uint32_t words[JOURNAL_HEADER_SIZE / 4];
+  memcpy(words, &header, sizeof(header));
+  if (!ESP.flashWrite(base, words, sizeof(words))) {
+    return false;
+  }
+
+  haveSector = true;
+  currentSector = sector;
+  currentSeq = header.seq;
+  highestSeq = header.seq;
+  currentVersion = version;
+  currentSize = size;
+  writePos = JOURNAL_HEADER_SIZE + recordSize(size);
+  needCompact = false;
+  journalStats.compactions++;
+  updateShadow(state, size);
+  updateStats();
+  return true;
+}
+
+// Следующий участок [start, end), отличающийся от shadow, начиная с start.
+// Совпадающие байты короче JOURNAL_MERGE_GAP остаются внутри участка
+static bool nextChange(const uint8_t* bytes, uint16_t size, uint16_t& start, uint16_t& end) {
+  while (start < size && bytes[start] == shadow[start]) {
+    start++;
+  }
+  if (start >= size) {
+    return false;
+  }
+  end = start + 1;
+  for (uint16_t j = end; j < size && j - end < JOURNAL_MERGE_GAP; j++) {
+    if (bytes[j] != shadow[j]) {
+      end = j + 1;
+    }
+  }
+  return true;
+}
+
+bool journalSave(const void* state, uint16_t size, uint8_t version) {
+  if (!journalAvailable() || size == 0 || size > JOURNAL_MAX_STATE_SIZE) {
+    return false;
+  }
+  if (!indexed) {
+    journalIndex();  // Тёплый старт без journalLoad(): найти, куда дописывать
+  }
+  if (!haveSector || needCompact || !shadow || version != currentVersion || size != currentSize) {
+    return compact(state, size, version);
+  }
+
+  const uint8_t* bytes = (const uint8_t*)state;
+
+  // Сначала считаем место: изменения и отметка либо дописываются все, либо уплотнение
+  uint16_t needed = recordSize(0);
+  uint16_t start = 0;
+  uint16_t end = 0;
+  while (nextChange(bytes, size, start, end)) {
+    needed += recordSize(end - start);
+    start = end;
+  }
+  if (needed == recordSize(0)) {
+    return true;
+  }
+  if (writePos + needed > JOURNAL_SECTOR_SIZE) {
+    return compact(state, size, version);
+  }
+
+  uint32_t base = settingsSectorAddress(currentSector);
+  start = 0;
+  while (nextChange(bytes, size, start, end)) {
+    if (!writeRecord(base + writePos, start, bytes + start, end - start)) {
+      // Хвост сектора в неизвестном состоянии: следующее сохранение - новый снимок
+      needCompact = true;
+      return false;
+    }
+    writePos += recordSize(end - start);
+    journalStats.records++;
+    start = end;
+  }
+  // Отметка последней: без неё при загрузке сохранение не применяется,
+  // и оборванная запись не смешивает старые и новые байты
+  if (!writeRecord(base + writePos, JOURNAL_COMMIT, nullptr, 0)) {
+    needCompact = true;
+    return false;
+  }
+  writePos += recordSize(0);
+
+  updateShadow(state, size);
+  updateStats();
+  return true;
+}
@@ -0,0 +1,78 @@
+#ifndef SETTINGS_JOURNAL_H
+#define SETTINGS_JOURNAL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Журнал настроек во флеше вместо EEPROM.put() всей структуры.
+// Занимает SETTINGS_JOURNAL_SECTORS секторов по 4 КБ. Сектор начинается
+// с полного снимка состояния, дальше дописываются только изменённые байты
+// (записи с CRC32). Записи одного сохранения закрываются отметкой, и при
+// загрузке применяются только сохранения с отметкой: оборванное сохранение
+// пропадает целиком, а не наполовину. Сектор стирается лишь при уплотнении:
+// когда записи не помещаются, снимок переносится в следующий сектор по кругу.
+// При загрузке берётся сектор с наибольшим номером.
+//
+// Журнал и пресеты лежат в начале раздела файловой системы (_FS_start).
+// Файловая система в прошивке не используется, но pio run -t uploadfs
+// и OTA образа файловой системы (U_FS) перезапишут раздел, а с ним
+// настройки и пресеты: после этого прошивка стартует с настройками по умолчанию.
+
+#define JOURNAL_SECTOR_SIZE 4096
+// Заголовок сектора и обрамление записи (смещение, длина, CRC)
+#define JOURNAL_HEADER_SIZE 16
+#define JOURNAL_RECORD_OVERHEAD 8
+// Самое большое состояние: снимок должен поместиться в сектор
+#define JOURNAL_MAX_STATE_SIZE (JOURNAL_SECTOR_SIZE - JOURNAL_HEADER_SIZE - JOURNAL_RECORD_OVERHEAD)
+
+// Статистика журнала (для /api/debug)
+struct JournalStats {
+  uint32_t records;      // Записей дописано с момента загрузки
+  uint32_t compactions;  // Уплотнений (стираний сектора) с момента загрузки
+  uint32_t seq;          // Номер текущего сектора в последовательности
+  uint8_t sector;        // Текущий сектор (0..SETTINGS_JOURNAL_SECTORS-1)
+  uint16_t usedBytes;    // Занято в текущем секторе
+};
+
+extern JournalStats journalStats;
+
+// Проверка собранного из журнала состояния (например, CRC и разбор TLV):
+// false - состояние испорчено, журнал предлагает более старое
+typedef bool (*JournalAccept)(const uint8_t* state, uint16_t size, uint8_t version);
+
+// Найти последний сектор и воспроизвести журнал в state (size байт).
+// version - версия структуры из заголовка, loadedSize - размер состояния
+// в журнале (у старых версий меньше size, хвост state не трогается).
+// Если accept отвергает последнее сохранение, берутся предыдущие сохранения
+// и снимок в начале сектора, затем сектора старше; следующее сохранение -
+// новый снимок.
+// Возвращает false, если журнала нет или ни одно состояние не принято.
+bool journalLoad(void* state, uint16_t size, uint8_t& version, uint16_t& loadedSize,
+                 JournalAccept accept = nullptr);
+
+// Найти текущий сектор и последнее сохранение, не собирая состояние для
+// вызывающего: так делает journalLoad(), но после тёплого старта (ledState
+// из RTC памяти) он не вызывается. Сохранению нужно знать сектор, номер
+// и сохранённые байты, иначе оно начнёт журнал заново с сектора 0.
+// journalSave() вызывает его сам, если ни одна из функций ещё не вызывалась.
+// Возвращает false, если журнала нет.
+bool journalIndex();
+
+// Сохранить state: дописать изменённые байты или уплотнить в новый сектор.
+// При смене версии или размера всегда пишется новый снимок.
+bool journalSave(const void* state, uint16_t size, uint8_t version);
+
+// CRC32 (IEEE 802.3, не crc32() ядра ESP8266). Для продолжения по следующему куску данных
+// передаётся результат предыдущего вызова
+uint32_t journalCrc32(const void* data, size_t length, uint32_t crc = 0);
+
+// Область настроек во флеше: сначала журнал, за ним пресеты (preset_store.h)
+#define SETTINGS_AREA_SECTORS (SETTINGS_JOURNAL_SECTORS + SETTINGS_PRESET_SECTORS)
+
+// Адрес сектора sector (0..SETTINGS_AREA_SECTORS-1) области настроек
+uint32_t settingsSectorAddress(uint8_t sector);
+
+// Область настроек во флеше есть (на ESP8266 - раздел файловой системы)
+bool journalAvailable();
+
+#endif
@@ -0,0 +1,373 @@
+#include "settings_schema.h"
+#include "settings_journal.h"
+#include "led_modes.h"
+#include <stddef.h>
+
+// Номера тегов записаны во флеше: не менять и не переиспользовать
+enum SchemaTag : uint8_t {
+  TAG_POWER = 1,
+  TAG_BRIGHTNESS = 2,
+  TAG_NUM_LEDS = 3,
+  TAG_CURRENT_MODE = 4,
+  TAG_AUTO_SWITCH_DELAY = 5,
+  TAG_RANDOM_ORDER = 6,
+  TAG_MODE_SETTINGS = 7,   // Число режимов, размер элемента, элементы MODE_ENTRY_SIZE
+  TAG_SCHEDULES = 8,       // Число расписаний, размер элемента, элементы SCHEDULE_ENTRY_SIZE
+  TAG_TRANSITION_MS = 9,
+  TAG_POWER_LIMIT_MA = 10,
+  TAG_PALETTE_SOURCE = 11, // По байту на режим
+  TAG_USER_PALETTE = 12    // Число точек, затем MAX_PALETTE_STOPS точек (pos, r, g, b)
+};
+
+// speed, scale, color1 (3), color2 (3), brightness, archived
+#define MODE_ENTRY_SIZE 10
+// enabled, hour, minute, action, daysOfWeek, preset
+#define SCHEDULE_ENTRY_SIZE 6
+#define PALETTE_STOP_SIZE 4
+// CRC32 и длина записей
+#define SCHEMA_HEADER_SIZE 6
+#define TLV_HEADER_SIZE 3
+
+// ---------- Версии 1-3: структура целиком ----------
+
+// Раскладка LEDState исходной прошивки (версия 3), как её писал EEPROM.put().
+// Версия 1 - та же структура без расписаний
+#define LEGACY_TOTAL_MODES 13
+#define LEGACY_SCHEDULES 10
+
+struct LegacyModeSettings {
+  uint8_t speed;
+  uint8_t scale;
+  uint8_t color1[3];
+  uint8_t color2[3];
+  uint8_t brightness;
+  uint8_t archived;
+};
+
+struct LegacySchedule {
+  uint8_t enabled;
+  uint8_t hour;
+  uint8_t minute;
+  uint8_t action;
+  uint8_t daysOfWeek;
+};
+
+struct LegacyState {
+  uint8_t power;
+  uint8_t brightness;
+  uint16_t numLeds;
+  uint8_t currentMode;
+  uint16_t autoSwitchDelay;
+  uint8_t randomOrder;
+  LegacyModeSettings modeSettings[LEGACY_TOTAL_MODES];
+  LegacySchedule schedules[LEGACY_SCHEDULES];        // С версии 2
+};
+
+static_assert(sizeof(LegacyState) == SCHEMA_LEGACY_SIZE, "LegacyState layout");
+static_assert(offsetof(LegacyState, schedules) == 139, "LegacyState layout");
+
+// Сколько байт структуры было в версии version
+static uint16_t legacySize(uint8_t version) {
+  return version >= 2 ? sizeof(LegacyState) : offsetof(LegacyState, schedules);
+}
+
+static void decodeLegacy(const uint8_t* data, uint8_t version) {
+  LegacyState legacy;
+  memcpy(&legacy, data, legacySize(version));
+
+  ledState.power = legacy.power;
+  ledState.brightness = legacy.brightness;
+  ledState.numLeds = legacy.numLeds;
+  ledState.currentMode = legacy.currentMode;
+  ledState.autoSwitchDelay = legacy.autoSwitchDelay;
+  ledState.randomOrder = legacy.randomOrder;
+  for (uint8_t i = 0; i < LEGACY_TOTAL_MODES && i < TOTAL_MODES; i++) {
+    const LegacyModeSettings& m = legacy.modeSettings[i];
+    ledState.modeSettings[i].speed = m.speed;
+    ledState.modeSettings[i].scale = m.scale;
+    ledState.modeSettings[i].color1 = CRGB(m.color1[0], m.color1[1], m.color1[2]);
+    ledState.modeSettings[i].color2 = CRGB(m.color2[0], m.color2[1], m.color2[2]);
+    ledState.modeSettings[i].brightness = m.brightness;
+    ledState.modeSettings[i].archived = m.archived;
+  }
+  if (version >= 2) {
+    for (uint8_t i = 0; i < LEGACY_SCHEDULES && i < MAX_SCHEDULES; i++) {
+      const LegacySchedule& s = legacy.schedules[i];
+      ledState.schedules[i] = {(bool)s.enabled, s.hour, s.minute, (bool)s.action, s.daysOfWeek, 0};
+    }
+  }
+}
+
+// ---------- Версия 4+: TLV ----------
+
+static inline uint16_t readU16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static inline void writeU16(uint8_t* p, uint16_t value) {
+  p[0] = value & 0xFF;
+  p[1] = value >> 8;
+}
+
+// Байт index элемента массива или fallback, если элемент короче (старая версия)
+static inline uint8_t entryField(const uint8_t* entry, uint8_t entrySize, uint8_t index, uint8_t fallback) {
+  return index < entrySize ? entry[index] : fallback;
+}
+
+struct TLVWriter {
+  uint8_t* out;
+  uint16_t capacity;
+  uint16_t pos;
+  bool overflow;
+
+  // Заголовок записи; возвращает место под значение или nullptr
+  uint8_t* put(uint8_t tag, uint16_t length) {
+    if ((uint32_t)pos + TLV_HEADER_SIZE + length > capacity) {
+      overflow = true;
+      return nullptr;
+    }
+    uint8_t* p = out + pos;
+    p[0] = tag;
+    writeU16(p + 1, length);
+    pos += TLV_HEADER_SIZE + length;
+    return p + TLV_HEADER_SIZE;
+  }
+
+  void putU8(uint8_t tag, uint8_t value) {
+    uint8_t* p = put(tag, 1);
+    if (p) p[0] = value;
+  }
+
+  void putU16(uint8_t tag, uint16_t value) {
+    uint8_t* p = put(tag, 2);
+    if (p) writeU16(p, value);
+  }
+};
+
+uint16_t encodeLEDState(uint8_t* out, uint16_t capacity) {
+  TLVWriter w = {out, capacity, SCHEMA_HEADER_SIZE, capacity < SCHEMA_HEADER_SIZE};
+
+  w.putU8(TAG_POWER, ledState.power);
+  w.putU8(TAG_BRIGHTNESS, ledState.brightness);
+  w.putU16(TAG_NUM_LEDS, ledState.numLeds);
+  w.putU8(TAG_CURRENT_MODE, ledState.currentMode);
+  w.putU16(TAG_AUTO_SWITCH_DELAY, ledState.autoSwitchDelay);
+  w.putU8(TAG_RANDOM_ORDER, ledState.randomOrder);
+
+  uint8_t* p = w.put(TAG_MODE_SETTINGS, 2 + TOTAL_MODES * MODE_ENTRY_SIZE);
+  if (p) {
+    *p++ = TOTAL_MODES;
+    *p++ = MODE_ENTRY_SIZE;
+    for (uint8_t i = 0; i < TOTAL_MODES; i++, p += MODE_ENTRY_SIZE) {
+      const ModeSettings& m = ledState.modeSettings[i];
+      const uint8_t entry[MODE_ENTRY_SIZE] = {m.speed, m.scale, m.color1.r, m.color1.g, m.color1.b,
+                                              m.color2.r, m.color2.g, m.color2.b, m.brightness, m.archived};
+      memcpy(p, entry, MODE_ENTRY_SIZE);
+    }
+  }
+
+  p = w.put(TAG_SCHEDULES, 2 + MAX_SCHEDULES * SCHEDULE_ENTRY_SIZE);
+  if (p) {
+    *p++ = MAX_SCHEDULES;
+    *p++ = SCHEDULE_ENTRY_SIZE;
+    for (uint8_t i = 0; i < MAX_SCHEDULES; i++, p += SCHEDULE_ENTRY_SIZE) {
+      const Schedule& s = ledState.schedules[i];
+      const uint8_t entry[SCHEDULE_ENTRY_SIZE] = {s.enabled, s.hour, s.minute, s.action, s.daysOfWeek, s.preset};
+      memcpy(p, entry, SCHEDULE_ENTRY_SIZE);
+    }
+  }
+
+  w.putU16(TAG_TRANSITION_MS, ledState.transitionMs);
+  w.putU16(TAG_POWER_LIMIT_MA, ledState.powerLimitMa);
+
+  p = w.put(TAG_PALETTE_SOURCE, 1 + TOTAL_MODES);
+  if (p) {
+    *p++ = TOTAL_MODES;
+    memcpy(p, ledState.paletteSource, TOTAL_MODES);
+  }
+
+  // Все точки, даже неиспользуемые: размер записи не зависит от палитры
+  p = w.put(TAG_USER_PALETTE, 1 + MAX_PALETTE_STOPS * PALETTE_STOP_SIZE);
+  if (p) {
+    *p++ = ledState.userPalette.count;
+    for (uint8_t i = 0; i < MAX_PALETTE_STOPS; i++, p += PALETTE_STOP_SIZE) {
+      const PaletteStop& stop = ledState.userPalette.stops[i];
+      p[0] = stop.pos;
+      p[1] = stop.color.r;
+      p[2] = stop.color.g;
+      p[3] = stop.color.b;
+    }
+  }
+
+  if (w.overflow) {
+    return 0;
+  }
+  uint16_t length = w.pos - SCHEMA_HEADER_SIZE;
+  writeU16(out + 4, length);
+  uint32_t crc = journalCrc32(out + 4, 2 + length);
+  memcpy(out, &crc, sizeof(crc));
+  return w.pos;
+}
+
+// CRC и границы всех записей - до того, как трогать ledState
+static bool checkTLV(const uint8_t* data, uint16_t length) {
+  if (length < SCHEMA_HEADER_SIZE) {
+    return false;
+  }
+  uint16_t recordsLength = readU16(data + 4);
+  if (recordsLength > length - SCHEMA_HEADER_SIZE) {
+    return false;
+  }
+  uint32_t crc;
+  memcpy(&crc, data, sizeof(crc));
+  if (crc != journalCrc32(data + 4, 2 + recordsLength)) {
+    return false;
+  }
+  uint16_t pos = SCHEMA_HEADER_SIZE;
+  uint16_t end = SCHEMA_HEADER_SIZE + recordsLength;
+  while (pos < end) {
+    if (pos + TLV_HEADER_SIZE > end || pos + TLV_HEADER_SIZE + readU16(data + pos + 1) > end) {
+      return false;
+    }
+    pos += TLV_HEADER_SIZE + readU16(data + pos + 1);
+  }
+  return true;
+}
+
+static void decodeRecord(uint8_t tag, const uint8_t* value, uint16_t length) {
+  switch (tag) {
+    case TAG_POWER:
+      if (length >= 1) ledState.power = value[0];
+      break;
+    case TAG_BRIGHTNESS:
+      if (length >= 1) ledState.brightness = value[0];
+      break;
+    case TAG_NUM_LEDS:
+      if (length >= 2) ledState.numLeds = readU16(value);
+      break;
+    case TAG_CURRENT_MODE:
+      if (length >= 1) ledState.currentMode = value[0];
+      break;
+    case TAG_AUTO_SWITCH_DELAY:
+      if (length >= 2) ledState.autoSwitchDelay = readU16(value);
+      break;
+    case TAG_RANDOM_ORDER:
+      if (length >= 1) ledState.randomOrder = value[0];
+      break;
+    case TAG_MODE_SETTINGS: {
+      // Режимы сверх сохранённых (добавленные в прошивку позже) - по умолчанию
+      if (length < 2 || 2 + value[0] * value[1] > length) break;
+      uint8_t size = value[1];
+      for (uint8_t i = 0; i < value[0] && i < TOTAL_MODES; i++) {
+        const uint8_t* e = value + 2 + i * size;
+        ModeSettings& m = ledState.modeSettings[i];
+        m.speed = entryField(e, size, 0, m.speed);
+        m.scale = entryField(e, size, 1, m.scale);
+        m.color1 = CRGB(entryField(e, size, 2, m.color1.r), entryField(e, size, 3, m.color1.g),
+                        entryField(e, size, 4, m.color1.b));
+        m.color2 = CRGB(entryField(e, size, 5, m.color2.r), entryField(e, size, 6, m.color2.g),
+                        entryField(e, size, 7, m.color2.b));
+        m.brightness = entryField(e, size, 8, m.brightness);
+        m.archived = entryField(e, size, 9, m.archived);
+      }
+      break;
+    }
+    case TAG_SCHEDULES: {
+      if (length < 2 || 2 + value[0] * value[1] > length) break;
+      uint8_t size = value[1];
+      for (uint8_t i = 0; i < value[0] && i < MAX_SCHEDULES; i++) {
+        const uint8_t* e = value + 2 + i * size;
+        Schedule& s = ledState.schedules[i];
+        s.enabled = entryField(e, size, 0, s.enabled);
+        s.hour = entryField(e, size, 1, s.hour);
+        s.minute = entryField(e, size, 2, s.minute);
+        s.action = entryField(e, size, 3, s.action);
+        s.daysOfWeek = entryField(e, size, 4, s.daysOfWeek);
+        s.preset = entryField(e, size, 5, s.preset);
+      }
+      break;
+    }
+    case TAG_TRANSITION_MS:
+      if (length >= 2) ledState.transitionMs = readU16(value);
+      break;
+    case TAG_POWER_LIMIT_MA:
+      if (length >= 2) ledState.powerLimitMa = readU16(value);
+      break;
+    case TAG_PALETTE_SOURCE:
+      if (length < 1 || 1 + value[0] > length) break;
+      for (uint8_t i = 0; i < value[0] && i < TOTAL_MODES; i++) {
+        ledState.paletteSource[i] = value[1 + i];
+      }
+      break;
+    case TAG_USER_PALETTE: {
+      if (length < 1) break;
+      uint16_t stops = (length - 1) / PALETTE_STOP_SIZE;
+      ledState.userPalette.count = value[0] <= stops && value[0] <= MAX_PALETTE_STOPS ? value[0] : 0;
+      for (uint8_t i = 0; i < stops && i < MAX_PALETTE_STOPS; i++) {
+        const uint8_t* stop = value + 1 + i * PALETTE_STOP_SIZE;
+        ledState.userPalette.stops[i] = {stop[0], CRGB(stop[1], stop[2], stop[3])};
+      }
+      break;
+    }
+    default:
+      // Тег из более новой прошивки
+      break;
+  }
+}
+
+static void decodeTLV(const uint8_t* data) {
+  uint16_t end = SCHEMA_HEADER_SIZE + readU16(data + 4);
+  uint16_t pos = SCHEMA_HEADER_SIZE;
+  while (pos < end) {
+    uint16_t length = readU16(data + pos + 1);
+    decodeRecord(data[pos], data + pos + TLV_HEADER_SIZE, length);
+    pos += TLV_HEADER_SIZE + length;
+  }
+}
+
+// ---------- Миграции ----------
+
+// Шаг toVersion приводит данные версии toVersion - 1 к версии toVersion.
+// Поля, которых в старой версии не было, уже заполнены значениями
+// по умолчанию, поэтому шаг нужен, только если менялся смысл сохранённых данных.
+struct Migration {
+  uint8_t toVersion;
+  void (*apply)();
+};
+
+// v3 -> v4: исходная прошивка color1 не читала и не меняла ("Один цвет"
+// светил белым), сохранённый красный - не выбор пользователя
+static void migrateDefaultColor1() {
+  for (uint8_t i = 0; i < TOTAL_MODES; i++) {
+    ledState.modeSettings[i].color1 = MODE_REGISTRY[i].defaultColor1;
+  }
+}
+
+// v1 -> v2 (расписания) и v2 -> v3 добавляли поля: хватает значений по умолчанию.
+// Поля, появившиеся вместе с TLV (переход, лимит тока, палитры), - тоже
+static const Migration MIGRATIONS[] = {
+  {4, migrateDefaultColor1},
+};
+
+bool decodeLEDState(const uint8_t* data, uint16_t length, uint8_t version) {
+  if (version == 0 || version > EEPROM_VERSION) {
+    return false;
+  }
+  if (version < SCHEMA_TLV_VERSION ? length < legacySize(version) : !checkTLV(data, length)) {
+    return false;
+  }
+
+  initLEDState();
+  if (version < SCHEMA_TLV_VERSION) {
+    decodeLegacy(data, version);
+  } else {
+    decodeTLV(data);
+  }
+
+  for (const Migration& step : MIGRATIONS) {
+    if (step.toVersion > version) {
+      step.apply();
+    }
+  }
+  return true;
+}
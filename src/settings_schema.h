@@ -0,0 +1,39 @@
+#ifndef SETTINGS_SCHEMA_H
+#define SETTINGS_SCHEMA_H
+
+#include <Arduino.h>
+#include "led_state.h"
+
+// Формат сохранённого LEDState.
+// До версии 3 (исходная прошивка) в EEPROM писалась сама структура (EEPROM.put),
+// с версии 4 - записи TLV: тег (1 байт), длина (2 байта), значение.
+// Перед записями - CRC32 и длина записей. Массивы режимов и расписаний
+// хранятся как "число элементов, размер элемента, элементы", поэтому
+// новый режим или новое поле в конце элемента не сдвигает остальные данные.
+// Неизвестные теги пропускаются, отсутствующие поля остаются по умолчанию.
+
+// Первая версия в формате TLV
+#define SCHEMA_TLV_VERSION 4
+
+// Размер закодированного состояния (не зависит от значений полей,
+// поэтому в журнале настроек изменения остаются на своих смещениях)
+#define SCHEMA_ENCODED_SIZE (6 + 3 * 12 + 1 + 1 + 2 + 1 + 2 + 1 \
+                             + 2 + TOTAL_MODES * 10 \
+                             + 2 + MAX_SCHEDULES * 6 \
+                             + 2 + 2 \
+                             + 1 + TOTAL_MODES \
+                             + 1 + MAX_PALETTE_STOPS * 4)
+
+// Размер структуры LEDState версии 3 (исходная прошивка, хранилась как есть)
+#define SCHEMA_LEGACY_SIZE 190
+
+// Закодировать ledState в TLV. Возвращает длину или 0, если не хватило места
+uint16_t encodeLEDState(uint8_t* out, uint16_t capacity);
+
+// Прочитать состояние версии version (структура v1-v3 или TLV) в ledState.
+// Чтение идёт за один проход от значений по умолчанию, затем по цепочке
+// применяются миграции от version до EEPROM_VERSION.
+// Возвращает false (ledState не тронут), если версия неизвестна или CRC не сошёлся.
+bool decodeLEDState(const uint8_t* data, uint16_t length, uint8_t version);
+
+#endif
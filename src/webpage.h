@@ -89,6 +89,16 @@ const char WEBPAGE[] PROGMEM = R"rawliteral(
                 </div>
             </div>
 
+            <!-- Power Limit -->
+            <div class="mb-3 p-2 bg-white bg-opacity-10 rounded-xl">
+                <div class="flex items-center justify-between">
+                    <span class="text-white text-base font-semibold">⚡ Лимит тока, мА</span>
+                    <input type="number" id="powerLimit" min="0" max="60000" step="500" value="9000"
+                           class="bg-white bg-opacity-20 text-white px-3 py-1 rounded-lg w-24 text-center text-sm"
+                           onchange="updatePowerLimit(this.value)">
+                </div>
+            </div>
+
             <!-- Settings and Schedule Buttons -->
             <div class="flex gap-2">
                 <button onclick="openSettings()" 
@@ -170,6 +180,12 @@ const char WEBPAGE[] PROGMEM = R"rawliteral(
                        class="w-full bg-white bg-opacity-20 text-white px-4 py-2 rounded-lg">
             </div>
 
+            <div class="mb-4">
+                <label class="text-white block mb-2">Плавный переход (мс, 0 = мгновенно)</label>
+                <input type="number" id="transitionMs" min="0" max="10000" step="100" value="1000"
+                       class="w-full bg-white bg-opacity-20 text-white px-4 py-2 rounded-lg">
+            </div>
+
             <div class="mb-6">
                 <label class="flex items-center text-white cursor-pointer">
                     <input type="checkbox" id="randomOrder" class="mr-2">
@@ -216,6 +232,22 @@ const char WEBPAGE[] PROGMEM = R"rawliteral(
                        oninput="updateModeSettings()">
             </div>
 
+            <div class="mb-3">
+                <label class="text-white block mb-1 text-sm">Палитра</label>
+                <div class="flex gap-2 items-center">
+                    <select id="modePalette" onchange="updateModeSettings()"
+                            class="flex-1 bg-white bg-opacity-20 text-white px-2 py-1 rounded-lg text-sm">
+                        <option value="builtin" class="text-black">Радуга</option>
+                        <option value="colors" class="text-black">Цвет 1 → Цвет 2</option>
+                        <option value="custom" class="text-black">Загруженная</option>
+                    </select>
+                    <input type="color" id="modeColor1" value="#ff0000" oninput="updateModeSettings()"
+                           class="w-10 h-8 rounded cursor-pointer">
+                    <input type="color" id="modeColor2" value="#0000ff" oninput="updateModeSettings()"
+                           class="w-10 h-8 rounded cursor-pointer">
+                </div>
+            </div>
+
             <div class="mb-3">
                 <button id="archiveButton" onclick="toggleArchiveFromSettings()" 
                         class="w-full bg-orange-500 hover:bg-orange-600 text-white font-bold py-2 px-3 rounded-lg text-sm">
@@ -308,22 +340,8 @@ const char WEBPAGE[] PROGMEM = R"rawliteral(
     </div>
 
     <script>
-        // Названия режимов
-const modeNames = [
-    "Смешанные волны",    // Blendwave
-    "Радужная пульсация", // Rainbow Beat
-    "Две синусоиды",      // Two Sin
-    "Конфетти",           // Confetti
-    "Огонь",              // Fire
-    "Радужный марш",      // Rainbow March
-    "Плазма",             // Plasma
-    "Шум",                // Noise
-    "Жонглирование",      // Juggle
-    "Один цвет",          // Solid Color
-    "Снегопад",           // Snowfall
-    "Северное сияние",    // Aurora
-    "Светлячки"           // Fireflies
-];
+        // Названия режимов приходят из реестра режимов на устройстве (/api/state)
+        let modeNames = [];
 
         let currentModeId = 0;  // Currently active mode on device
         let editingModeId = null;  // Mode currently being edited (null if settings modal closed)
@@ -406,6 +424,11 @@ const modeNames = [
             }, 500);
         }
 
+        // Update power limit (0 = без ограничения)
+        async function updatePowerLimit(value) {
+            await apiCall('/api/leds', { powerLimitMa: parseInt(value) });
+        }
+
         // Select mode
         async function selectMode(modeId) {
             debugLog('selectMode: selecting mode ' + modeId + ' (was ' + currentModeId + ')');
@@ -476,6 +499,9 @@ const modeNames = [
                 document.getElementById('modeSpeed').value = settings.speed;
                 document.getElementById('modeScale').value = settings.scale;
                 document.getElementById('modeBrightness').value = settings.brightness;
+                document.getElementById('modePalette').value = settings.palette;
+                document.getElementById('modeColor1').value = settings.color1;
+                document.getElementById('modeColor2').value = settings.color2;
                 
                 // Update archive button text
                 const archiveBtn = document.getElementById('archiveButton');
@@ -516,6 +542,9 @@ const modeNames = [
                 const speed = document.getElementById('modeSpeed').value;
                 const scale = document.getElementById('modeScale').value;
                 const brightness = document.getElementById('modeBrightness').value;
+                const palette = document.getElementById('modePalette').value;
+                const color1 = document.getElementById('modeColor1').value;
+                const color2 = document.getElementById('modeColor2').value;
                 
                 debugLog('updateModeSettings: Sending settings for mode ' + editingModeId + ': speed=' + speed + ', scale=' + scale + ', brightness=' + brightness);
                 
@@ -523,7 +552,10 @@ const modeNames = [
                     modeId: editingModeId,
                     speed: parseInt(speed),
                     scale: parseInt(scale),
-                    brightness: parseInt(brightness)
+                    brightness: parseInt(brightness),
+                    palette: palette,
+                    color1: color1,
+                    color2: color2
                 });
                 
                 debugLog('updateModeSettings: API result: ' + JSON.stringify(result));
@@ -533,6 +565,9 @@ const modeNames = [
                     modeSettingsCache[editingModeId].speed = parseInt(speed);
                     modeSettingsCache[editingModeId].scale = parseInt(scale);
                     modeSettingsCache[editingModeId].brightness = parseInt(brightness);
+                    modeSettingsCache[editingModeId].palette = palette;
+                    modeSettingsCache[editingModeId].color1 = color1;
+                    modeSettingsCache[editingModeId].color2 = color2;
                     debugLog('updateModeSettings: Local cache updated for mode ' + editingModeId);
                 }
             }, 300);
@@ -552,9 +587,11 @@ const modeNames = [
         async function saveSettings() {
             const delay = document.getElementById('autoSwitchDelay').value;
             const random = document.getElementById('randomOrder').checked;
+            const transition = document.getElementById('transitionMs').value;
             await apiCall('/api/auto-switch', {
                 delay: parseInt(delay),
-                random: random
+                random: random,
+                transition: parseInt(transition)
             });
             closeSettings();
         }
@@ -566,8 +603,10 @@ const modeNames = [
             if (state) {
                 updatePowerToggleUI(state.power);
                 document.getElementById('ledCount').value = state.numLeds;
+                document.getElementById('powerLimit').value = state.powerLimitMa;
                 document.getElementById('autoSwitchDelay').value = state.autoSwitchDelay;
                 document.getElementById('randomOrder').checked = state.randomOrder;
+                document.getElementById('transitionMs').value = state.transitionMs;
                 
                 const prevModeId = currentModeId;
                 currentModeId = state.currentMode;
@@ -578,6 +617,7 @@ const modeNames = [
                 // Cache mode settings
                 if (state.modeSettings) {
                     modeSettingsCache = state.modeSettings;
+                    modeNames = state.modeSettings.map(mode => mode.name);
                     debugLog('loadState: modeSettingsCache updated, ' + modeSettingsCache.length + ' modes');
                 }
                 
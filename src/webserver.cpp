@@ -2,6 +2,14 @@
 #include "webpage.h"
 #include "config.h"
 #include "logger.h"
+#include "led_modes.h"
+#include "mode_bench.h"
+#include "diagnostics.h"
+#include "led_output.h"
+#include "palette.h"
+#include "settings_journal.h"
+#include "rtc_state.h"
+#include "preset_store.h"
 #include <ArduinoJson.h>
 #include <ESP8266WiFi.h>
 
@@ -34,6 +42,55 @@ bool checkThrottle() {
   return true;
 }
 
+// Цвет в JSON передаётся строкой "#rrggbb": ровно 6 шестнадцатеричных цифр
+// (strtoul сам по себе пропустил бы "#-1" и "#+ff")
+static bool parseHexColor(const char* text, CRGB& color) {
+  if (text == nullptr || text[0] != '#' || strlen(text) != 7) {
+    return false;
+  }
+  for (uint8_t i = 1; i < 7; i++) {
+    if (!isxdigit((unsigned char)text[i])) {
+      return false;
+    }
+  }
+  color = CRGB(strtoul(text + 1, nullptr, 16));
+  return true;
+}
+
+// Необязательное поле 0-255. false - поле есть, но не число в этом диапазоне
+static bool readByteField(JsonDocument& doc, const char* key, uint8_t& value) {
+  if (!doc.containsKey(key)) {
+    return true;
+  }
+  long number = doc[key] | -1L;
+  if (number < 0 || number > 255) {
+    return false;
+  }
+  value = number;
+  return true;
+}
+
+static String formatHexColor(const CRGB& color) {
+  char buf[8];
+  snprintf(buf, sizeof(buf), "#%02x%02x%02x", color.r, color.g, color.b);
+  return String(buf);
+}
+
+static const char* PALETTE_SOURCE_NAMES[] = {"builtin", "colors", "custom"};
+
+static int parsePaletteSource(const char* name) {
+  for (uint8_t i = 0; i < sizeof(PALETTE_SOURCE_NAMES) / sizeof(PALETTE_SOURCE_NAMES[0]); i++) {
+    if (name != nullptr && strcmp(name, PALETTE_SOURCE_NAMES[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static const char* paletteSourceName(uint8_t source) {
+  return source < sizeof(PALETTE_SOURCE_NAMES) / sizeof(PALETTE_SOURCE_NAMES[0]) ? PALETTE_SOURCE_NAMES[source] : "builtin";
+}
+
 // WebSocket event handler
 void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type,
                void *arg, uint8_t *data, size_t len) {
@@ -77,6 +134,8 @@ void setupWebServer() {
   server.on("/api/schedules", HTTP_GET, handleGetSchedules);
   server.on("/api/time", HTTP_GET, handleGetTime);
   server.on("/api/debug", HTTP_GET, handleGetDebug);
+  server.on("/api/bench", HTTP_GET, handleGetBench);
+  server.on("/api/presets", HTTP_GET, handleGetPresets);
   
   // API endpoints - POST requests with body
   // Note: The first lambda is called when request completes (after body), 
@@ -114,6 +173,18 @@ void setupWebServer() {
   server.on("/api/time/set", HTTP_POST, 
     [](AsyncWebServerRequest *request){ LOG_PRINTLN("POST /api/time/set complete"); }, 
     NULL, handleSetTime);
+  server.on("/api/preset/save", HTTP_POST, 
+    [](AsyncWebServerRequest *request){ LOG_PRINTLN("POST /api/preset/save complete"); }, 
+    NULL, handleSavePreset);
+  server.on("/api/preset/apply", HTTP_POST, 
+    [](AsyncWebServerRequest *request){ LOG_PRINTLN("POST /api/preset/apply complete"); }, 
+    NULL, handleApplyPreset);
+  server.on("/api/preset/delete", HTTP_POST, 
+    [](AsyncWebServerRequest *request){ LOG_PRINTLN("POST /api/preset/delete complete"); }, 
+    NULL, handleDeletePreset);
+  server.on("/api/bench", HTTP_POST, 
+    [](AsyncWebServerRequest *request){ LOG_PRINTLN("POST /api/bench complete"); }, 
+    NULL, handleStartBench);
   
   // DELETE request
   server.on("/api/schedules", HTTP_DELETE, handleDeleteSchedule);
@@ -142,15 +213,29 @@ void handleGetState(AsyncWebServerRequest *request) {
   doc["currentMode"] = ledState.currentMode;
   doc["autoSwitchDelay"] = ledState.autoSwitchDelay;
   doc["randomOrder"] = ledState.randomOrder;
+  doc["transitionMs"] = ledState.transitionMs;
+  doc["powerLimitMa"] = ledState.powerLimitMa;
   
   // Добавляем настройки всех режимов
   JsonArray modes = doc.createNestedArray("modeSettings");
   for (int i = 0; i < TOTAL_MODES; i++) {
     JsonObject mode = modes.createNestedObject();
+    mode["name"] = MODE_REGISTRY[i].name;
+    mode["frameMs"] = MODE_REGISTRY[i].frameMs;
     mode["speed"] = ledState.modeSettings[i].speed;
     mode["scale"] = ledState.modeSettings[i].scale;
     mode["brightness"] = ledState.modeSettings[i].brightness;
     mode["archived"] = ledState.modeSettings[i].archived;
+    mode["color1"] = formatHexColor(ledState.modeSettings[i].color1);
+    mode["color2"] = formatHexColor(ledState.modeSettings[i].color2);
+    mode["palette"] = paletteSourceName(ledState.paletteSource[i]);
+  }
+  
+  JsonArray stops = doc.createNestedArray("userPalette");
+  for (uint8_t i = 0; i < ledState.userPalette.count; i++) {
+    JsonObject stop = stops.createNestedObject();
+    stop["pos"] = ledState.userPalette.stops[i].pos;
+    stop["color"] = formatHexColor(ledState.userPalette.stops[i].color);
   }
   
   String response;
@@ -209,9 +294,18 @@ void handleSetLEDs(AsyncWebServerRequest *request, uint8_t *data, size_t len, si
   DeserializationError error = deserializeJson(doc, (const char*)data, len);
   
   if (!error) {
-    uint16_t count = doc["count"];
-    if (count > 0 && count <= MAX_LEDS) {
+    // Значения читаются как long и проверяются до записи в uint16_t:
+    // иначе 70000 мА молча превратились бы в 4464
+    long count = doc["count"] | (long)ledState.numLeds;
+    bool hasPowerLimit = doc.containsKey("powerLimitMa");
+    long powerLimit = doc["powerLimitMa"] | -1L;
+    if (count > 0 && count <= MAX_LEDS &&
+        (!hasPowerLimit || (powerLimit >= 0 && powerLimit <= MAX_POWER_LIMIT_MA))) {
       ledState.numLeds = count;
+      if (hasPowerLimit) {
+        ledState.powerLimitMa = powerLimit;
+        LOG_PRINTF("API: Power limit %d mA\n", ledState.powerLimitMa);
+      }
       settingsChanged = true;
       request->send(200, "application/json", "{\"success\":true}");
       return;
@@ -267,7 +361,7 @@ void handleSetModeSettings(AsyncWebServerRequest *request, uint8_t *data, size_t
   rawBody[copyLen] = '\0';
   LOG_PRINTF("API: SetModeSettings - Raw body: %s\n", rawBody);
   
-  StaticJsonDocument<512> doc;
+  StaticJsonDocument<1024> doc;
   DeserializationError error = deserializeJson(doc, (const char*)data, len);
   
   if (error) {
@@ -298,15 +392,59 @@ void handleSetModeSettings(AsyncWebServerRequest *request, uint8_t *data, size_t
              ledState.modeSettings[modeId].scale,
              ledState.modeSettings[modeId].brightness);
   
-  if (doc.containsKey("speed")) {
-    ledState.modeSettings[modeId].speed = doc["speed"];
+  // Сначала всё проверяется на копиях, ledState меняется только если
+  // запрос корректен целиком: ошибка в цвете не оставляет применённую скорость
+  ModeSettings settings = ledState.modeSettings[modeId];
+  uint8_t paletteSource = ledState.paletteSource[modeId];
+  UserPalette palette = ledState.userPalette;
+  
+  if (!readByteField(doc, "speed", settings.speed) ||
+      !readByteField(doc, "scale", settings.scale) ||
+      !readByteField(doc, "brightness", settings.brightness)) {
+    request->send(400, "application/json", "{\"error\":\"speed, scale and brightness must be 0-255\"}");
+    return;
   }
-  if (doc.containsKey("scale")) {
-    ledState.modeSettings[modeId].scale = doc["scale"];
+  
+  // Палитра: цвета режима, источник и общая загруженная палитра
+  if (doc.containsKey("color1") && !parseHexColor(doc["color1"], settings.color1)) {
+    request->send(400, "application/json", "{\"error\":\"Invalid color1\"}");
+    return;
   }
-  if (doc.containsKey("brightness")) {
-    ledState.modeSettings[modeId].brightness = doc["brightness"];
+  if (doc.containsKey("color2") && !parseHexColor(doc["color2"], settings.color2)) {
+    request->send(400, "application/json", "{\"error\":\"Invalid color2\"}");
+    return;
   }
+  if (doc.containsKey("stops")) {
+    JsonArray stops = doc["stops"];
+    if (stops.size() < 2 || stops.size() > MAX_PALETTE_STOPS) {
+      request->send(400, "application/json", "{\"error\":\"Palette needs 2-8 stops\"}");
+      return;
+    }
+    palette.count = stops.size();
+    for (uint8_t i = 0; i < palette.count; i++) {
+      long pos = stops[i]["pos"] | -1L;
+      bool ordered = pos >= 0 && pos <= 255 && (i == 0 || pos > palette.stops[i - 1].pos);
+      if (!ordered || !parseHexColor(stops[i]["color"], palette.stops[i].color)) {
+        request->send(400, "application/json", "{\"error\":\"Invalid palette stop\"}");
+        return;
+      }
+      palette.stops[i].pos = pos;
+    }
+    paletteSource = PALETTE_CUSTOM;
+  }
+  if (doc.containsKey("palette")) {
+    int source = parsePaletteSource(doc["palette"]);
+    if (source < 0) {
+      request->send(400, "application/json", "{\"error\":\"Unknown palette\"}");
+      return;
+    }
+    paletteSource = source;
+  }
+  
+  ledState.modeSettings[modeId] = settings;
+  ledState.paletteSource[modeId] = paletteSource;
+  ledState.userPalette = palette;
+  invalidatePalettes();
   
   // Log values after update
   LOG_PRINTF("API: Mode %d AFTER: speed=%d, scale=%d, brightness=%d\n", 
@@ -329,11 +467,14 @@ void handleGetModeSettings(AsyncWebServerRequest *request) {
       return;
     }
     
-    StaticJsonDocument<256> doc;
+    StaticJsonDocument<384> doc;
     doc["speed"] = ledState.modeSettings[modeId].speed;
     doc["scale"] = ledState.modeSettings[modeId].scale;
     doc["brightness"] = ledState.modeSettings[modeId].brightness;
     doc["archived"] = ledState.modeSettings[modeId].archived;
+    doc["color1"] = formatHexColor(ledState.modeSettings[modeId].color1);
+    doc["color2"] = formatHexColor(ledState.modeSettings[modeId].color2);
+    doc["palette"] = paletteSourceName(ledState.paletteSource[modeId]);
     
     String response;
     serializeJson(doc, response);
@@ -372,8 +513,8 @@ void handleResetModeSettings(AsyncWebServerRequest *request, uint8_t *data, size
     LOG_PRINTF("API: Reset Settings for Mode %d\n", modeId);
     
     // Reset to default values
-    ledState.modeSettings[modeId].speed = 128;
-    ledState.modeSettings[modeId].scale = 128;
+    ledState.modeSettings[modeId].speed = MODE_REGISTRY[modeId].defaultSpeed;
+    ledState.modeSettings[modeId].scale = MODE_REGISTRY[modeId].defaultScale;
     ledState.modeSettings[modeId].brightness = 255;
     // Don't reset archived status or colors
     
@@ -437,10 +578,16 @@ void handleSetAutoSwitch(AsyncWebServerRequest *request, uint8_t *data, size_t l
   StaticJsonDocument<200> doc;
   DeserializationError error = deserializeJson(doc, (const char*)data, len);
   
-  if (!error) {
+  // Переход читается как long и проверяется до записи в uint16_t (как powerLimitMa)
+  bool hasTransition = !error && doc.containsKey("transition");
+  long transition = hasTransition ? (doc["transition"] | -1L) : 0;
+  if (!error && (!hasTransition || (transition >= 0 && transition <= MAX_TRANSITION_MS))) {
     ledState.autoSwitchDelay = doc["delay"];
     ledState.randomOrder = doc["random"];
-    LOG_PRINTF("API: AutoSwitch Delay=%d, Random=%d\n", ledState.autoSwitchDelay, ledState.randomOrder);
+    if (hasTransition) {
+      ledState.transitionMs = transition;
+    }
+    LOG_PRINTF("API: AutoSwitch Delay=%d, Random=%d, Transition=%dms\n", ledState.autoSwitchDelay, ledState.randomOrder, ledState.transitionMs);
     settingsChanged = true;
     request->send(200, "application/json", "{\"success\":true}");
     return;
@@ -461,6 +608,7 @@ void handleGetSchedules(AsyncWebServerRequest *request) {
     schedule["minute"] = ledState.schedules[i].minute;
     schedule["action"] = ledState.schedules[i].action;
     schedule["daysOfWeek"] = ledState.schedules[i].daysOfWeek;
+    schedule["preset"] = (int)ledState.schedules[i].preset - 1;
   }
   
   String response;
@@ -500,6 +648,15 @@ void handleSetSchedule(AsyncWebServerRequest *request, uint8_t *data, size_t len
     if (doc.containsKey("daysOfWeek")) {
       ledState.schedules[id].daysOfWeek = doc["daysOfWeek"];
     }
+    if (doc.containsKey("preset")) {
+      // -1 = без пресета
+      int preset = doc["preset"];
+      if (preset < -1 || preset >= MAX_PRESETS) {
+        request->send(400, "application/json", "{\"error\":\"Invalid preset ID\"}");
+        return;
+      }
+      ledState.schedules[id].preset = preset + 1;
+    }
     
     LOG_PRINTF("API: Set Schedule %d. Act=%d, Time=%d:%d\n", id, ledState.schedules[id].action, ledState.schedules[id].hour, ledState.schedules[id].minute);
     
@@ -584,8 +741,14 @@ void handleSetTime(AsyncWebServerRequest *request, uint8_t *data, size_t len, si
   request->send(400, "application/json", "{\"error\":\"Invalid request\"}");
 }
 
+// Полей в ответе /api/debug: при добавлении поля увеличить, иначе поля
+// молча пропадут (слот поля - 16 байт на ESP8266 и 32 на native)
+#define DEBUG_JSON_FIELDS 38
+// Скопированные строки: formattedTime и ipAddress
+#define DEBUG_JSON_STRINGS 32
+
 void handleGetDebug(AsyncWebServerRequest *request) {
-  DynamicJsonDocument doc(1024);
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(DEBUG_JSON_FIELDS) + DEBUG_JSON_STRINGS);
   
   // NTP info
   doc["ntpServer"] = NTP_SERVER;
@@ -618,7 +781,209 @@ void handleGetDebug(AsyncWebServerRequest *request) {
   // Uptime
   doc["uptimeMs"] = millis();
   
+  // LED output
+  doc["framesShown"] = frameStats.shown;
+  doc["framesSkipped"] = frameStats.skipped;
+  doc["transitionsShortened"] = frameStats.transitionsShortened;
+  
+  // Power limiter
+  doc["powerLimitMa"] = ledState.powerLimitMa;
+  doc["powerEstimateMa"] = powerStats.estimatedMa;
+  doc["powerRequestedMa"] = powerStats.requestedMa;
+  doc["powerScale"] = powerStats.scale;
+  doc["powerThrottledFrames"] = powerStats.throttledFrames;
+  doc["framesLate"] = diag.getFramesLate();
+  doc["framesDropped"] = diag.getFramesDropped();
+  doc["effectiveFps"] = diag.getEffectiveFps();
+  doc["frameIntervalMs"] = diag.frameInterval(ledState.currentMode);
+  doc["frameCostUs"] = diag.getFrameCostUs(ledState.currentMode);
+  
+  // Settings persistence
+  doc["settingsPendingChanges"] = saveStats.pendingChanges;
+  doc["settingsCoalesced"] = saveStats.coalesced;
+  doc["settingsCommits"] = saveStats.commits;
+  doc["settingsForcedFlushes"] = saveStats.forcedFlushes;
+  doc["journalRecords"] = journalStats.records;
+  doc["journalCompactions"] = journalStats.compactions;
+  doc["journalSeq"] = journalStats.seq;
+  doc["journalSector"] = journalStats.sector;
+  doc["journalUsedBytes"] = journalStats.usedBytes;
+  doc["rtcWarmBoot"] = rtcStateStats.warmBoot;
+  doc["rtcCrashBoots"] = rtcStateStats.crashBoots;
+  doc["rtcWrites"] = rtcStateStats.writes;
+  
+  if (doc.overflowed()) {
+    LOG_PRINTLN("❌ /api/debug: JSON document overflowed, raise DEBUG_JSON_FIELDS");
+    request->send(500, "application/json", "{\"error\":\"Debug document overflowed\"}");
+    return;
+  }
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
+// Список пресетов ещё не прочитан из флеша: его прочитает loop(), клиент повторит запрос
+static bool presetsLoading(AsyncWebServerRequest *request) {
+  if (requestPresetIndex()) {
+    return false;
+  }
+  request->send(503, "application/json", "{\"error\":\"Presets loading, retry\"}");
+  return true;
+}
+
+void handleGetPresets(AsyncWebServerRequest *request) {
+  if (presetsLoading(request)) {
+    return;
+  }
+  DynamicJsonDocument doc(4096);
+  
+  // Из копии в памяти: флеш в async колбэке не читается
+  JsonArray presets = doc.createNestedArray("presets");
+  for (uint8_t id = 0; id < MAX_PRESETS; id++) {
+    const char* name = presetName(id);
+    if (name) {
+      JsonObject item = presets.createNestedObject();
+      item["id"] = id;
+      item["name"] = name;
+      item["mode"] = presetMode(id);
+    }
+  }
+  doc["max"] = MAX_PRESETS;
+  
+  String response;
+  serializeJson(doc, response);
+  request->send(200, "application/json", response);
+}
+
+void handleSavePreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (!checkThrottle()) {
+    request->send(429, "application/json", "{\"error\":\"Too many requests\"}");
+    return;
+  }
+  
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, (const char*)data, len);
+  const char* name = doc["name"];
+  
+  if (error || !name || !name[0] || strlen(name) >= PRESET_NAME_LEN) {
+    request->send(400, "application/json", "{\"error\":\"Invalid preset name\"}");
+    return;
+  }
+  
+  // Запись во флеш выполняет loop(); здесь только ставим запрос
+  if (!requestPresetSave(name)) {
+    request->send(409, "application/json", "{\"error\":\"Preset store busy\"}");
+    return;
+  }
+  
+  LOG_PRINTF("API: Save preset \"%s\"\n", name);
+  request->send(202, "application/json", "{\"success\":true}");
+}
+
+// Найти пресет по "id" или "name" в теле запроса, -1 - не найден
+static int8_t presetFromRequest(const JsonDocument& doc) {
+  if (doc.containsKey("id")) {
+    int id = doc["id"];
+    return id >= 0 && id < MAX_PRESETS && presetName(id) ? id : -1;
+  }
+  const char* name = doc["name"];
+  return name ? findPreset(name) : -1;
+}
+
+void handleApplyPreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (!checkThrottle()) {
+    request->send(429, "application/json", "{\"error\":\"Too many requests\"}");
+    return;
+  }
+  
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, (const char*)data, len);
+  if (error) {
+    request->send(400, "application/json", "{\"error\":\"Invalid request\"}");
+    return;
+  }
+  
+  if (presetsLoading(request)) {
+    return;
+  }
+  int8_t id = presetFromRequest(doc);
+  if (id < 0) {
+    request->send(404, "application/json", "{\"error\":\"Preset not found\"}");
+    return;
+  }
+  
+  // Пресет читается из флеша и применяется в loop(), сохраняется, только если попросили
+  bool save = doc["save"] | false;
+  if (!requestPresetApply(id, save)) {
+    request->send(409, "application/json", "{\"error\":\"Preset store busy\"}");
+    return;
+  }
+  
+  LOG_PRINTF("API: Apply preset %d%s\n", id, save ? " (save)" : "");
+  request->send(202, "application/json", "{\"success\":true}");
+}
+
+void handleDeletePreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (!checkThrottle()) {
+    request->send(429, "application/json", "{\"error\":\"Too many requests\"}");
+    return;
+  }
+  
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, (const char*)data, len);
+  if (error) {
+    request->send(400, "application/json", "{\"error\":\"Invalid request\"}");
+    return;
+  }
+  
+  if (presetsLoading(request)) {
+    return;
+  }
+  int8_t id = presetFromRequest(doc);
+  if (id < 0) {
+    request->send(404, "application/json", "{\"error\":\"Preset not found\"}");
+    return;
+  }
+  if (!requestPresetDelete(id)) {
+    request->send(409, "application/json", "{\"error\":\"Preset store busy\"}");
+    return;
+  }
+  
+  LOG_PRINTF("API: Delete preset %d\n", id);
+  request->send(202, "application/json", "{\"success\":true}");
+}
+
+void handleGetBench(AsyncWebServerRequest *request) {
+  DynamicJsonDocument doc(4096);
+  fillModeBenchJson(doc);
+  
   String response;
   serializeJson(doc, response);
   request->send(200, "application/json", response);
 }
+
+void handleStartBench(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (!checkThrottle()) {
+    request->send(429, "application/json", "{\"error\":\"Too many requests\"}");
+    return;
+  }
+  
+  StaticJsonDocument<200> doc;
+  DeserializationError error = deserializeJson(doc, (const char*)data, len);
+  
+  if (error) {
+    request->send(400, "application/json", "{\"error\":\"Invalid request\"}");
+    return;
+  }
+  
+  // Замеры выполняет loop(); здесь только ставим запрос
+  uint16_t frames = doc["frames"] | BENCH_DEFAULT_FRAMES;
+  if (!requestModeBench(frames)) {
+    request->send(409, "application/json", "{\"error\":\"Benchmark already running\"}");
+    return;
+  }
+  
+  LOG_PRINTF("API: Mode benchmark requested, %d frames\n", frames);
+  request->send(202, "application/json", "{\"success\":true}");
+}
@@ -43,6 +43,12 @@ void handleDeleteSchedule(AsyncWebServerRequest *request);
 void handleGetTime(AsyncWebServerRequest *request);
 void handleSetTime(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 void handleGetDebug(AsyncWebServerRequest *request);
+void handleGetPresets(AsyncWebServerRequest *request);
+void handleSavePreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+void handleApplyPreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+void handleDeletePreset(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+void handleGetBench(AsyncWebServerRequest *request);
+void handleStartBench(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
 void handleNotFound();
 
 #endif
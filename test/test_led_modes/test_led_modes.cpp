@@ -0,0 +1,89 @@
+// Режимы и общие часы анимации (led_modes.h): pio test -e native
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_state.h"
+#include "led_modes.h"
+#include "native_platform.h"
+
+void setUp() {
+  nativeOptions.virtualClock = true;
+  initLEDState();
+  initLEDs();
+}
+
+void tearDown() {
+}
+
+// Волна с вынесенной фазой должна повторять beatsin8 пиксель в пиксель
+static void test_beatsin_wave_matches_beatsin8() {
+  static const uint8_t bpms[] = {0, 1, 8, 17, 25};
+  static const uint8_t steps[] = {0, 5, 22, 50, 255};
+  for (uint16_t t = 0; t < 50; t++) {
+    nativeAdvanceClock(37);
+    animClock.ms = t * 53;  // Часы анимации отстают от millis()
+    for (uint8_t bpm : bpms) {
+      for (uint8_t step : steps) {
+        BeatsinWave wave(bpm, step, 128);
+        for (uint16_t i = 0; i < MAX_LEDS; i++) {
+          if (wave.next() != beatsin8(bpm, 0, 255, animTimebase(), i * step + 128)) {
+            char message[64];
+            snprintf(message, sizeof(message), "bpm %u, step %u, pixel %u", bpm, step, i);
+            TEST_FAIL_MESSAGE(message);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Режимы на волнах FastLED берут время из animClock: тот же animClock.ms
+// при другом millis() (например, после тёплого перезапуска) - тот же кадр
+static void test_beat_modes_follow_animation_clock() {
+  static const ModeRenderFunc modes[] = {mode_blendwave, mode_rainbow_beat, mode_two_sin};
+  static CRGB first[MAX_LEDS];
+  for (ModeRenderFunc render : modes) {
+    ledState.currentMode = 0;
+    while (MODE_REGISTRY[ledState.currentMode].render != render) {
+      ledState.currentMode++;
+    }
+    animClock.ms = 123456;
+    animClock.deltaMs = 0;
+    render();
+    memcpy(first, leds, sizeof(first));
+
+    nativeAdvanceClock(7777);
+    render();
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(first, leds, sizeof(first), MODE_REGISTRY[ledState.currentMode].name);
+  }
+}
+
+// При кадре в FRAME_MAX_INTERVAL_MS (20 FPS под нагрузкой) симуляция
+// не теряет время: шаги × stepMs плюс остаток равны времени анимации
+static void test_simulation_keeps_up_at_max_frame_interval() {
+  for (uint8_t stepMs = 1; stepMs <= 80; stepMs++) {
+    SimClock clock;
+    uint32_t steps = 0;
+    animClock.deltaMs = 0;
+    advanceSimulation(clock, stepMs, [&]() { steps++; });  // Первый шаг - сразу
+    
+    const uint16_t frames = 200;
+    animClock.deltaMs = FRAME_MAX_INTERVAL_MS;
+    for (uint16_t frame = 0; frame < frames; frame++) {
+      advanceSimulation(clock, stepMs, [&]() { steps++; });
+    }
+    
+    uint32_t simulatedMs = (steps - 1) * stepMs + clock.accumMs;
+    char message[32];
+    snprintf(message, sizeof(message), "stepMs %u", stepMs);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE((uint32_t)frames * FRAME_MAX_INTERVAL_MS, simulatedMs, message);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_beatsin_wave_matches_beatsin8);
+  RUN_TEST(test_beat_modes_follow_animation_clock);
+  RUN_TEST(test_simulation_keeps_up_at_max_frame_interval);
+  return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// Выходной каскад (led_output.h): pio test -e native
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_state.h"
+#include "led_modes.h"
+#include "led_output.h"
+#include "native_platform.h"
+
+void setUp() {
+  initLEDState();
+  initLEDs();
+}
+
+void tearDown() {
+}
+
+// Воспринимаемый уровень = выход, усреднённый за цикл дизеринга.
+// Он не должен убывать ни по значению канала, ни по яркости: иначе при
+// ночной яркости на плавных градиентах появятся ступеньки и провалы.
+static void test_output_ramp_monotonic() {
+  const uint16_t rampSize = MAX_LEDS < 256 ? MAX_LEDS : 256;
+  static CRGB ramp[256];
+  for (uint16_t v = 0; v < rampSize; v++) {
+    ramp[v] = CRGB(v, v, v);
+  }
+
+  static uint16_t prevBrightness[256][3];
+  memset(prevBrightness, 0, sizeof(prevBrightness));
+
+  for (uint16_t brightness = 0; brightness < 256; brightness++) {
+    setOutputBrightness(brightness);
+
+    uint16_t sums[256][3] = {};
+    for (uint8_t frame = 0; frame < OUTPUT_DITHER_STEPS; frame++) {
+      renderOutput(ramp, rampSize);
+      for (uint16_t v = 0; v < rampSize; v++) {
+        for (uint8_t c = 0; c < 3; c++) {
+          sums[v][c] += outputLeds[v][c];
+        }
+      }
+    }
+
+    for (uint16_t v = 0; v < rampSize; v++) {
+      for (uint8_t c = 0; c < 3; c++) {
+        if ((v > 0 && sums[v][c] < sums[v - 1][c]) || sums[v][c] < prevBrightness[v][c]) {
+          char message[80];
+          snprintf(message, sizeof(message), "brightness %u, value %u, channel %u", brightness, v, c);
+          TEST_FAIL_MESSAGE(message);
+        }
+        prevBrightness[v][c] = sums[v][c];
+      }
+    }
+  }
+  setOutputBrightness(255);
+}
+
+// Неподвижный кадр с тёмными уровнями (ниже LED_DITHER_BELOW на выходе):
+// выводится count раз подряд, возвращает число вызовов show()
+static uint32_t showStaticDarkFrame(uint8_t brightness, uint8_t count) {
+  nativeOptions.virtualClock = true;
+  ledState.brightness = brightness;
+  fill_solid(leds, MAX_LEDS, CRGB(120, 60, 30));
+  uint32_t shownBefore = frameStats.shown;
+  for (uint8_t i = 0; i < count; i++) {
+    nativeAdvanceClock(20);  // Меньше LED_REFRESH_INTERVAL за все кадры
+    showFrame();
+  }
+  return frameStats.shown - shownBefore;
+}
+
+// На полной и обычной яркости дизеринга нет: неподвижный кадр
+// выводится один раз и дальше пропускается
+static void test_static_frame_skipped_at_full_brightness() {
+  TEST_ASSERT_TRUE(showStaticDarkFrame(255, 10) <= 1);
+}
+
+static void test_static_frame_skipped_at_default_brightness() {
+  TEST_ASSERT_TRUE(showStaticDarkFrame(DEFAULT_BRIGHTNESS, 10) <= 1);
+}
+
+// Ночью дизеринг продолжает добирать тёмные уровни
+static void test_static_frame_dithered_at_night_brightness() {
+  TEST_ASSERT_EQUAL(10, showStaticDarkFrame(LED_DITHER_MAX_BRIGHTNESS - 10, 10));
+}
+
+// Лента стала короче: отключённые диоды гаснут, ток считается только по подключённым
+static void test_shorter_strip_clears_tail() {
+  setOutputBrightness(255);
+  ledState.numLeds = 20;
+  fill_solid(leds, MAX_LEDS, CRGB::White);
+  showLeds();
+  TEST_ASSERT_TRUE(outputLeds[19].r > 0);
+
+  ledState.numLeds = 10;
+  showLeds();
+  TEST_ASSERT_TRUE(outputLeds[9].r > 0);
+  for (uint16_t i = 10; i < MAX_LEDS; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(!outputLeds[i], "LED past numLeds is lit");
+  }
+  uint32_t litMa = 10 * (LED_RED_MA + LED_GREEN_MA + LED_BLUE_MA + LED_IDLE_MA);
+  TEST_ASSERT_TRUE(powerStats.estimatedMa > litMa / 2 && powerStats.estimatedMa <= litMa);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_output_ramp_monotonic);
+  RUN_TEST(test_static_frame_skipped_at_full_brightness);
+  RUN_TEST(test_static_frame_skipped_at_default_brightness);
+  RUN_TEST(test_static_frame_dithered_at_night_brightness);
+  RUN_TEST(test_shorter_strip_clears_tail);
+  return UNITY_END();
+}
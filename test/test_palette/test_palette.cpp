@@ -0,0 +1,61 @@
+// Палитры и пакетный HSV (palette.h): pio test -e native
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_state.h"
+#include "led_modes.h"
+#include "palette.h"
+
+static CHSV input[MAX_LEDS];
+static CRGB actual[MAX_LEDS];
+
+void setUp() {
+  initLEDState();
+  initLEDs();
+}
+
+void tearDown() {
+}
+
+// Случайные тон и яркость; насыщенность 255 (таблица радуги) или вся шкала
+static void checkHsvStrip(bool fullSat, uint16_t seed) {
+  random16_set_seed(seed);
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    uint8_t hue = random8();
+    uint8_t sat = fullSat ? 255 : random8();
+    input[i] = CHSV(hue, sat, random8());
+  }
+  hsv2rgbStrip(actual, input, MAX_LEDS);
+  for (uint16_t i = 0; i < MAX_LEDS; i++) {
+    if (actual[i] != CRGB(input[i])) {
+      char message[64];
+      snprintf(message, sizeof(message), "hsv (%u, %u, %u)", input[i].h, input[i].s, input[i].v);
+      TEST_FAIL_MESSAGE(message);
+    }
+  }
+}
+
+// Пакетный путь должен давать ровно те же цвета, что CHSV
+static void test_hsv_strip_full_saturation() {
+  checkHsvStrip(true, 1);
+}
+
+static void test_hsv_strip_mixed_saturation() {
+  checkHsvStrip(false, 2);
+}
+
+// Режимы пишут CHSV прямо в leds[]: перевод на месте даёт тот же результат
+static void test_hsv_strip_in_place() {
+  checkHsvStrip(false, 3);
+  CRGB* pixels = (CRGB*)input;
+  hsv2rgbStrip(pixels, input, MAX_LEDS);
+  TEST_ASSERT_EQUAL_MEMORY(actual, pixels, sizeof(actual));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_hsv_strip_full_saturation);
+  RUN_TEST(test_hsv_strip_mixed_saturation);
+  RUN_TEST(test_hsv_strip_in_place);
+  return UNITY_END();
+}
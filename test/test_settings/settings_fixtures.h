@@ -0,0 +1,35 @@
+#ifndef SETTINGS_FIXTURES_H
+#define SETTINGS_FIXTURES_H
+
+// Настоящий образ настроек, записанный выпущенной прошивкой (исходная, v3).
+// Прошивка собрана из своего коммита (env:native), в ledState выставлены
+// значения ниже и вызван её saveLEDState(): EEPROM.put() заголовка
+// EEPROMHeader (8 байт, байты выравнивания - как их записала прошивка)
+// и структуры LEDState.
+//
+// brightness 200, numLeds 150, режим 7, авто-переключение 300 с, случайный порядок;
+// режим i: speed 10+i, scale 100+i, color1 (16i, 0x20, 0x30), color2 (0x40, 8i, 0x50),
+// brightness 250-i, архивный только режим 3;
+// расписание i: включено при i<2, час 7+i, минута 5i, action при i=0, дни 0x7F>>i.
+// Прошивок v1 и v2 в истории нет: их структуры - начало структуры v3.
+
+#include <stdint.h>
+
+// v3 (исходная прошивка): коммит d621dde, EEPROMHeader + LEDState (190 байт)
+static const uint8_t EEPROM_V3_IMAGE[198] = {
+  0x56, 0x44, 0x45, 0x4c, 0x03, 0x7f, 0x00, 0x00, 0x01, 0xc8, 0x96, 0x00, 0x07, 0x00, 0x2c, 0x01,
+  0x01, 0x0a, 0x64, 0x00, 0x20, 0x30, 0x40, 0x00, 0x50, 0xfa, 0x00, 0x0b, 0x65, 0x10, 0x20, 0x30,
+  0x40, 0x08, 0x50, 0xf9, 0x00, 0x0c, 0x66, 0x20, 0x20, 0x30, 0x40, 0x10, 0x50, 0xf8, 0x00, 0x0d,
+  0x67, 0x30, 0x20, 0x30, 0x40, 0x18, 0x50, 0xf7, 0x01, 0x0e, 0x68, 0x40, 0x20, 0x30, 0x40, 0x20,
+  0x50, 0xf6, 0x00, 0x0f, 0x69, 0x50, 0x20, 0x30, 0x40, 0x28, 0x50, 0xf5, 0x00, 0x10, 0x6a, 0x60,
+  0x20, 0x30, 0x40, 0x30, 0x50, 0xf4, 0x00, 0x11, 0x6b, 0x70, 0x20, 0x30, 0x40, 0x38, 0x50, 0xf3,
+  0x00, 0x12, 0x6c, 0x80, 0x20, 0x30, 0x40, 0x40, 0x50, 0xf2, 0x00, 0x13, 0x6d, 0x90, 0x20, 0x30,
+  0x40, 0x48, 0x50, 0xf1, 0x00, 0x14, 0x6e, 0xa0, 0x20, 0x30, 0x40, 0x50, 0x50, 0xf0, 0x00, 0x15,
+  0x6f, 0xb0, 0x20, 0x30, 0x40, 0x58, 0x50, 0xef, 0x00, 0x16, 0x70, 0xc0, 0x20, 0x30, 0x40, 0x60,
+  0x50, 0xee, 0x00, 0x01, 0x07, 0x00, 0x01, 0x7f, 0x01, 0x08, 0x05, 0x00, 0x3f, 0x00, 0x09, 0x0a,
+  0x00, 0x1f, 0x00, 0x0a, 0x0f, 0x00, 0x0f, 0x00, 0x0b, 0x14, 0x00, 0x07, 0x00, 0x0c, 0x19, 0x00,
+  0x03, 0x00, 0x0d, 0x1e, 0x00, 0x01, 0x00, 0x0e, 0x23, 0x00, 0x00, 0x00, 0x0f, 0x28, 0x00, 0x00,
+  0x00, 0x10, 0x2d, 0x00, 0x00, 0x00,
+};
+
+#endif
@@ -0,0 +1,126 @@
+// Формат сохранённых настроек (settings_schema.h): pio test -e native
+
+#include <Arduino.h>
+#include <unity.h>
+#include "led_state.h"
+#include "led_modes.h"
+#include "palette.h"
+#include "settings_schema.h"
+#include "settings_journal.h"
+#include "native_platform.h"
+#include <stdio.h>
+#include "settings_fixtures.h"
+
+void setUp() {
+  nativeOptions.flashPath = "test_settings_flash.bin";
+  remove(nativeOptions.flashPath);
+  initLEDState();
+}
+
+void tearDown() {
+  remove(nativeOptions.flashPath);
+}
+
+// Поля, которых в версии ещё не было, остаются по умолчанию
+static void checkMigrated(uint8_t version, const char* message) {
+  const LEDState& s = ledState;
+  TEST_ASSERT_EQUAL_MESSAGE(200, s.brightness, message);
+  TEST_ASSERT_EQUAL_MESSAGE(150, s.numLeds, message);
+  TEST_ASSERT_EQUAL_MESSAGE(7, s.currentMode, message);
+  TEST_ASSERT_EQUAL_MESSAGE(300, s.autoSwitchDelay, message);
+  TEST_ASSERT_EQUAL_MESSAGE(1, s.randomOrder, message);
+  TEST_ASSERT_EQUAL_MESSAGE(15, s.modeSettings[5].speed, message);
+  TEST_ASSERT_EQUAL_MESSAGE(238, s.modeSettings[12].brightness, message);
+  TEST_ASSERT_EQUAL_MESSAGE(1, s.modeSettings[3].archived, message);
+  TEST_ASSERT_EQUAL_MESSAGE(40, s.modeSettings[5].color2.g, message);
+  // Исходная прошивка не читала color1 ("Один цвет" светил белым): берётся умолчание режима
+  for (uint8_t i = 0; i < TOTAL_MODES; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(s.modeSettings[i].color1 == CRGB(MODE_REGISTRY[i].defaultColor1), message);
+  }
+  TEST_ASSERT_EQUAL_MESSAGE(version >= 2 ? 8 : 0, s.schedules[1].hour, message);
+  TEST_ASSERT_EQUAL_MESSAGE(version >= 2 ? 0x3F : 0x7F, s.schedules[1].daysOfWeek, message);
+  TEST_ASSERT_EQUAL_MESSAGE(DEFAULT_TRANSITION_MS, s.transitionMs, message);
+  TEST_ASSERT_EQUAL_MESSAGE(DEFAULT_POWER_LIMIT_MA, s.powerLimitMa, message);
+  TEST_ASSERT_EQUAL_MESSAGE(PALETTE_BUILTIN, s.paletteSource[2], message);
+  TEST_ASSERT_EQUAL_MESSAGE(0, s.userPalette.count, message);
+}
+
+static const uint8_t* const V3_STATE = EEPROM_V3_IMAGE + sizeof(EEPROMHeader);
+static const uint16_t V3_STATE_SIZE = sizeof(EEPROM_V3_IMAGE) - sizeof(EEPROMHeader);
+
+// Образ, записанный исходной прошивкой, читается с миграцией
+static void test_baseline_image_migrates() {
+  EEPROMHeader header;
+  memcpy(&header, EEPROM_V3_IMAGE, sizeof(header));
+  TEST_ASSERT_EQUAL(EEPROM_MAGIC, header.magic);
+  TEST_ASSERT_EQUAL(3, header.version);
+
+  TEST_ASSERT_TRUE(decodeLEDState(V3_STATE, V3_STATE_SIZE, header.version));
+  checkMigrated(header.version, "v3");
+}
+
+// Прошивок v1 и v2 не было в этой истории: их структура - начало v3
+static void test_pre_v3_layouts_migrate() {
+  for (uint8_t version = 1; version < 3; version++) {
+    char message[32];
+    snprintf(message, sizeof(message), "v%u", version);
+    initLEDState();
+    TEST_ASSERT_TRUE_MESSAGE(decodeLEDState(V3_STATE, V3_STATE_SIZE, version), message);
+    checkMigrated(version, message);
+  }
+}
+
+// Кодирование -> чтение -> кодирование без изменений
+static void test_tlv_round_trip() {
+  TEST_ASSERT_TRUE(decodeLEDState(V3_STATE, V3_STATE_SIZE, 3));
+  ledState.transitionMs = 1500;
+  ledState.powerLimitMa = 4000;
+  ledState.paletteSource[2] = PALETTE_CUSTOM;
+  static uint8_t encoded[SCHEMA_ENCODED_SIZE], reencoded[SCHEMA_ENCODED_SIZE];
+  uint16_t length = encodeLEDState(encoded, sizeof(encoded));
+  TEST_ASSERT_EQUAL(SCHEMA_ENCODED_SIZE, length);
+  initLEDState();
+  TEST_ASSERT_TRUE(decodeLEDState(encoded, length, EEPROM_VERSION));
+  TEST_ASSERT_EQUAL(1500, ledState.transitionMs);
+  TEST_ASSERT_EQUAL(PALETTE_CUSTOM, ledState.paletteSource[2]);
+  TEST_ASSERT_EQUAL(length, encodeLEDState(reencoded, sizeof(reencoded)));
+  TEST_ASSERT_EQUAL_MEMORY(encoded, reencoded, length);
+}
+
+// Испорченный байт: данные отвергаются, ledState не меняется
+static void test_damaged_tlv_rejected() {
+  static uint8_t encoded[SCHEMA_ENCODED_SIZE];
+  uint16_t length = encodeLEDState(encoded, sizeof(encoded));
+  encoded[length / 2] ^= 0x40;
+  ledState.brightness = 1;
+  TEST_ASSERT_FALSE(decodeLEDState(encoded, length, EEPROM_VERSION));
+  TEST_ASSERT_EQUAL(1, ledState.brightness);
+}
+
+// Сохранение с испорченным TLV во флеше: при загрузке берётся прошлое
+// целое состояние, а не настройки по умолчанию
+static void test_damaged_save_restores_last_good_state() {
+  loadLEDState();  // Пустая флеш - умолчания в журнал
+  ledState.brightness = 77;
+  saveLEDState();
+
+  static uint8_t encoded[SCHEMA_ENCODED_SIZE];
+  ledState.brightness = 78;
+  uint16_t length = encodeLEDState(encoded, sizeof(encoded));
+  encoded[length / 2] ^= 0x40;
+  TEST_ASSERT_TRUE(journalSave(encoded, length, EEPROM_VERSION));
+
+  initLEDState();
+  loadLEDState();
+  TEST_ASSERT_EQUAL(77, ledState.brightness);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_baseline_image_migrates);
+  RUN_TEST(test_pre_v3_layouts_migrate);
+  RUN_TEST(test_tlv_round_trip);
+  RUN_TEST(test_damaged_tlv_rejected);
+  RUN_TEST(test_damaged_save_restores_last_good_state);
+  return UNITY_END();
+}
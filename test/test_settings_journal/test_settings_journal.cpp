@@ -0,0 +1,172 @@
+// Журнал настроек во флеше (settings_journal.h): pio test -e native
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "settings_journal.h"
+#include "native_platform.h"
+
+#define STATE_SIZE 64
+
+static uint8_t saved[STATE_SIZE], loaded[STATE_SIZE];
+// Состояние "испорчено", если его первый байт - rejectedByte
+static uint8_t rejectedByte = 0;
+
+void setUp() {
+  nativeOptions.flashPath = "test_journal_flash.bin";
+  remove(nativeOptions.flashPath);
+  rejectedByte = 0;
+  // Как после включения питания: журнал ищется заново, флеш пуста
+  uint8_t version;
+  uint16_t size;
+  journalLoad(loaded, STATE_SIZE, version, size);
+}
+
+void tearDown() {
+  remove(nativeOptions.flashPath);
+}
+
+static void fillState(uint8_t* state, uint8_t seed) {
+  for (uint16_t i = 0; i < STATE_SIZE; i++) {
+    state[i] = seed + i * 7;
+  }
+}
+
+// Стереть байты флеши обратно в 0xFF: как будто запись до них не дошла
+static void eraseFlashBytes(uint32_t address, uint16_t length) {
+  FILE* f = fopen(nativeOptions.flashPath, "r+b");
+  TEST_ASSERT_NOT_NULL(f);
+  fseek(f, address, SEEK_SET);
+  for (uint16_t i = 0; i < length; i++) {
+    fputc(0xFF, f);
+  }
+  fclose(f);
+}
+
+static bool acceptState(const uint8_t* state, uint16_t size, uint8_t version) {
+  return size == STATE_SIZE && version == 1 && state[0] != rejectedByte;
+}
+
+static void assertLoads(const uint8_t* expected) {
+  uint8_t version = 0;
+  uint16_t size = 0;
+  memset(loaded, 0, sizeof(loaded));
+  TEST_ASSERT_TRUE(journalLoad(loaded, STATE_SIZE, version, size, acceptState));
+  TEST_ASSERT_EQUAL(1, version);
+  TEST_ASSERT_EQUAL(STATE_SIZE, size);
+  TEST_ASSERT_EQUAL_MEMORY(expected, loaded, STATE_SIZE);
+}
+
+// Снимок и изменения поверх него читаются обратно
+static void test_saves_replay_in_order() {
+  fillState(saved, 1);
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  for (uint8_t i = 0; i < 20; i++) {
+    saved[i * 3] ^= 0x5A;
+    saved[STATE_SIZE - 1] = i;
+    TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  }
+  assertLoads(saved);
+}
+
+// Сбой питания до отметки: сохранение из нескольких записей пропадает
+// целиком, следующее сохранение идёт в новый сектор и читается
+static void test_unfinished_save_ignored() {
+  static uint8_t before[STATE_SIZE];
+  fillState(before, 1);
+  TEST_ASSERT_TRUE(journalSave(before, STATE_SIZE, 1));
+
+  memcpy(saved, before, STATE_SIZE);
+  saved[0] ^= 0xFF;               // Изменения далеко друг от друга - две записи
+  saved[STATE_SIZE - 1] ^= 0xFF;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  uint32_t end = settingsSectorAddress(journalStats.sector) + journalStats.usedBytes;
+  eraseFlashBytes(end - JOURNAL_RECORD_OVERHEAD, JOURNAL_RECORD_OVERHEAD);
+  assertLoads(before);
+
+  uint8_t sector = journalStats.sector;
+  saved[10] ^= 0xFF;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  TEST_ASSERT_NOT_EQUAL(sector, journalStats.sector);
+  assertLoads(saved);
+}
+
+// Последние сохранения не прошли проверку: берётся предыдущее целое,
+// а следующее сохранение уходит в новый сектор
+static void test_rejected_save_falls_back_to_previous_one() {
+  static uint8_t previous[STATE_SIZE];
+  fillState(saved, 1);
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  saved[5] ^= 0xFF;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  memcpy(previous, saved, STATE_SIZE);
+  saved[0] = 0xEE;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  saved[9] ^= 0xFF;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+
+  rejectedByte = 0xEE;
+  assertLoads(previous);
+
+  uint8_t sector = journalStats.sector;
+  saved[0] = 0x11;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  TEST_ASSERT_NOT_EQUAL(sector, journalStats.sector);
+  assertLoads(saved);
+}
+
+// Новый сектор не прошёл проверку ни целиком, ни снимком: берётся прошлый
+static void test_rejected_sector_falls_back_to_older_one() {
+  static uint8_t older[STATE_SIZE];
+  fillState(older, 1);
+  TEST_ASSERT_TRUE(journalSave(older, STATE_SIZE, 1));
+  fillState(saved, 2);
+  saved[0] = 0xEE;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 2));  // Другая версия - новый сектор
+
+  rejectedByte = 0xEE;
+  assertLoads(older);
+
+  // Следующий снимок новее отвергнутого сектора
+  fillState(saved, 3);
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  assertLoads(saved);
+}
+
+// Тёплый старт: состояние из RTC памяти, journalLoad() не вызывался.
+// journalIndex() находит текущий сектор, сохранение дописывается в него,
+// а холодный старт после этого читает новое состояние
+static void test_warm_boot_save_continues_journal() {
+  // Холодный старт и сохранения до третьего сектора
+  fillState(saved, 1);
+  for (uint8_t i = 0; journalStats.sector != 2; i++) {
+    saved[i % STATE_SIZE] ^= 0x33;
+    saved[(i + STATE_SIZE / 2) % STATE_SIZE] ^= 0x33;
+    TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  }
+  uint32_t seq = journalStats.seq;
+  uint16_t used = journalStats.usedBytes;
+
+  // Тёплый старт
+  TEST_ASSERT_TRUE(journalIndex());
+  TEST_ASSERT_EQUAL(2, journalStats.sector);
+  TEST_ASSERT_EQUAL(seq, journalStats.seq);
+  TEST_ASSERT_EQUAL(used, journalStats.usedBytes);
+  saved[1] ^= 0xFF;
+  TEST_ASSERT_TRUE(journalSave(saved, STATE_SIZE, 1));
+  TEST_ASSERT_EQUAL(2, journalStats.sector);  // Дописано, а не снимок в сектор 0
+  TEST_ASSERT_EQUAL(seq, journalStats.seq);
+
+  // Холодный старт
+  assertLoads(saved);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_saves_replay_in_order);
+  RUN_TEST(test_unfinished_save_ignored);
+  RUN_TEST(test_rejected_save_falls_back_to_previous_one);
+  RUN_TEST(test_rejected_sector_falls_back_to_older_one);
+  RUN_TEST(test_warm_boot_save_continues_journal);
+  return UNITY_END();
+}